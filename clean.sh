@@ -15,3 +15,65 @@ do
   rm -rf kdiv_s32_p_${divs}.nac 
   rm -rf kdiv_s32_p_${divs}.c
 done
+
+rm -rf kdiv_s16_m_32768.nac
+
+rm -rf kdiv_u16_cert.txt kdiv_s16_cert.txt kdiv_u32_cert.txt kdiv_s32_cert.txt
+
+for mod in "10" "255" "65521" "998244353" "1000000007" "4294967291"
+do
+  rm -rf kmod_u32_${mod}.nac
+  rm -rf kmod_u32_${mod}.c
+  rm -rf kmod_u32_${mod}_bench.c
+done
+
+rm -rf kdiv_u32_dispatch.c
+rm -rf kdiv_s32_dispatch.c
+rm -rf kdiv_u32_dict.c
+rm -rf kdiv_u32_dict_bench.c
+rm -rf kdiv_s32_dict.c
+rm -rf kdiv_s32_dict_bench.c
+rm -rf kdiv_dict_bench.exe
+
+for div in "3" "7" "10" "641" "1000" "12345"
+do
+  rm -rf kdiv_u32_p_${div}_m16.nac
+  rm -rf kdiv_u32_p_${div}_m8.c
+  rm -rf kdiv_s32_m_${div}_m16.c
+  rm -rf kdiv_s16_p_${div}_m8.nac
+done
+
+for div in "1" "3" "10" "255" "1000000000" "2147483648" "4294967295"
+do
+  rm -rf kbig_u32_${div}.c
+  rm -rf kbig_u32_${div}_bench.c
+done
+
+for div in "1" "3" "7" "10" "641" "1000" "12345"
+do
+  rm -rf kdiv_u32_p_${div}_fp.c
+  rm -rf kdiv_u32_p_${div}_fp_bench.c
+  rm -rf kdiv_s32_m_${div}_fp.c
+  rm -rf kdiv_u24_p_${div}_fp.c
+done
+
+for div in "3" "7" "10" "641" "1000"
+do
+  rm -rf kdiv_u32_p_${div}_x4.c
+  rm -rf kdiv_u32_p_${div}_batch_bench.c
+  rm -rf kdiv_s32_m_${div}_x8.c
+  rm -rf kdiv_s32_p_${div}_x2.c
+done
+
+for div in "1" "2" "7" "10" "641" "1000"
+do
+  rm -rf kdiv_u32_p_${div}.c
+  rm -rf kdiv_s32_m_${div}_m16.c
+  rm -rf kdiv_s32_p_${div}.c
+done
+rm -rf kdiv_s32_m_7.c
+rm -rf kdiv_u32_p_7_m16.c
+
+rm -rf kdiv_batch_bench.exe
+rm -rf test.scan.o
+rm -rf test.scan.exe
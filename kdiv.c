@@ -1,8 +1,7 @@
 /*
  * File       : kdiv.c                                                          
  * Description: Generator and calculator for division by integer constant 
- *              routines. Routines "magic" and "magicu" have been copied
- *              from Herny S. Warren's "Hacker's Delight". 
+ *              routines. Command-line front-end to libkdiv.
  * Author     : Nikolaos Kavvadias <nikolaos.kavvadias@gmail.com>                
  * Copyright  : (C) Nikolaos Kavvadias 2011-2021
  * Website    : http://www.nkavvadias.com                            
@@ -25,606 +24,1490 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <stdarg.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <time.h>
+#include <dlfcn.h>
+#include "kdiv.h"
 
-/* Absolute value of an integer. */
-#define ABS(x)            ((x) >  0 ? (x) : (-x))
-
-// ------------------------------ cut ----------------------------------
-struct mu {unsigned int M;     // Magic number,
-          int a;               // "add" indicator,
-          int s;};             // and shift amount.
-
-struct ms {int M;          // Magic number
-          int s;};         // and shift amount.         
-// ---------------------------- end cut --------------------------------
+/* Number of divisors analyzed per parallel sweep step. */
+#define SWEEP_BLOCK       65536
+/* Largest operation count/depth tracked in the sweep histograms. */
+#define SWEEP_MAXOPS      15
+/* Number of dividends per call of the self-test routine. */
+#define SELFTEST_BLOCK    4096
+/* Mismatches recorded per self-test thread. */
+#define SELFTEST_NBAD     8
 
 int divisor=1, width=32, lo=0, hi=65535;
 int enable_debug=0, enable_errors=0;
 int is_signed=0;
 int enable_nac=1, enable_ansic=0;
+int enable_stats=0, enable_sweep=0, enable_csv=0, nthreads=0;
+int enable_prove=0, has_drange=0, has_nrange=0, has_bigdiv=0;
+int enable_bench=0, enable_fp=0;
+long long modulus=0, bigdiv=0;
+int nhot=12, divcost=26;
+int mulwidth=0, batch=0, enable_selftest=0;
+char *prof_name=NULL, *dict_name=NULL;
+long long dlo=1, dhi=65535;
+char *cert_name=NULL;
+char *cc_cmd="cc -std=c99 -pedantic -Wall -Wextra -Werror -O3 -march=native";
+
+/* Sweep analysis of a single divisor. */
+struct sweep_rec {
+  int err;
+  long long d;
+  unsigned int M;
+  int a, s;
+  struct kdiv_stats st;
+};
+
+/* Share of a block of divisors analyzed by one thread. */
+struct range_job {
+  long long first, last;
+  void *recs;
+};
 
 
-/*! Print a configurable number of space characters to an output file (specified 
- *  by the given filename; the file is assumed already opened).
+/*! Write the contents of an output buffer to the named file.
  */
-void print_spaces(FILE *f, int nspaces)
+static int write_file(const char *fname, const struct kdiv_buf *b)
 {
-  int i;  
-  for (i = 0; i < nspaces; i++)
+  FILE *fout;
+  
+  fout = fopen(fname, "w");
+  if (fout == NULL)
   {
-    fprintf(f, " ");
+    fprintf(stderr, "Error: Cannot open file %s for writing.\n", fname);
+    return (1);
   }
+  fwrite(b->data, 1, b->len, fout);
+  fclose(fout);
+  return (0);
 }
 
-/*! fprintf prefixed by a number of space characters. 
+/*! Run an emitter of a whole file into a buffer, growing the buffer if 
+ *  needed, and write the result to the named file.
  */
-void pfprintf(FILE *f, int nspaces, char *fmt, ...)
+static int emit_file(const char *fname, int (*fn)(struct kdiv_buf *, const void *),
+  const void *arg)
 {
-  va_list args;
-  print_spaces(f, nspaces);
-  va_start(args, fmt);
-  vfprintf(f, fmt, args);
-  va_end(args);
+  struct kdiv_buf b;
+  char data[4096], *heap=NULL;
+  int err, ret;
+  
+  kdiv_buf_init(&b, data, sizeof(data));
+  err = fn(&b, arg);
+  if (err == KDIV_E_NOSPACE)
+  {
+    heap = malloc(b.len + 1);
+    kdiv_buf_init(&b, heap, b.len + 1);
+    err = fn(&b, arg);
+  }
+  if (err != KDIV_OK)
+  {
+    fprintf(stderr, "Error: %s\n", kdiv_strerror(err));
+    free(heap);
+    return (1);
+  }
+  ret = write_file(fname, &b);
+  free(heap);
+  return (ret);
 }
 
-/*! Function to identify if the given unsigned integer is a power-of-2.
+/*! Parse a (possibly negative) integer argument.
  */
-int ispowof2(unsigned int v)
+static long long parse_ll(const char *str)
 {
-  int f;
-  f = v && !(v & (v-1));
-  return (f);
+  return (strtoll(str, NULL, 0));
 }
 
-/*! Function to calculate the ceiling of the binary logarithm of a given positive 
- *  integer n.
+/*! Return the number of worker threads to use for parallel analyses.
  */
-int log2ceil(unsigned int inpval)
+static int get_nthreads(void)
 {
-  unsigned int logval = 0;
+  long n;
+  
+  if (nthreads > 0)
+  {
+    return (nthreads);
+  }
+  n = sysconf(_SC_NPROCESSORS_ONLN);
+  return ((n > 0) ? (int)n : 1);
+}
 
-  if (inpval == 0)
+/*! Run fn on n jobs of jobsize bytes each, one thread per job. A job whose
+ *  thread cannot be created is run by the calling thread instead.
+ */
+static void run_parallel(void *(*fn)(void *), void *jobs, size_t jobsize, int n)
+{
+  pthread_t *tids;
+  char *started;
+  int i;
+  
+  tids = malloc(n * sizeof(pthread_t));
+  started = malloc(n);
+  if ((tids == NULL) || (started == NULL))
   {
-    fprintf(stderr, "Error: Result of log2 computation is MINUS_INFINITY.\n");
-    exit(1);
+    // Run all jobs in this thread.
+    for (i = 0; i < n; i++)
+    {
+      fn((char *)jobs + i*jobsize);
+    }
+    free(started);
+    free(tids);
+    return;
   }
-  // inpval is positive
-  else
+  for (i = 0; i < n; i++)
+  {
+    started[i] = (pthread_create(&tids[i], NULL, fn, 
+                   (char *)jobs + i*jobsize) == 0);
+    if (started[i] == 0)
+    {
+      fn((char *)jobs + i*jobsize);
+    }
+  }
+  for (i = 0; i < n; i++)
   {
-    unsigned int max = 1; // exp=0 => max=2^0=1
-    // log computation loop
-    while (max < inpval)
+    if (started[i] == 1)
     {
-      // increment exponent
-      logval = logval + 1;
-      //  max = 2^logval
-      max = max * 2;
+      pthread_join(tids[i], NULL);
     }
   }
+  free(started);
+  free(tids);
+}
 
-  // exponent that gives (2^logval) >= inpval
-  return (logval);
+/*! Print the cost metrics of a routine.
+ */
+static void print_stats(FILE *f, const char *name, const struct kdiv_stats *st)
+{
+  fprintf(f, "%s: pow2=%d add=%d fixup=%d shift=%d muls=%d ops=%d depth=%d lat=%d\n",
+    name, st->pow2, st->add, st->fixup, st->shift, st->muls, st->ops, 
+    st->depth, st->lat);
+}
+
+/*! Sweep thread body: analyze the divisors of one share of a block.
+ */
+static void *sweep_worker(void *arg)
+{
+  struct range_job *job = arg;
+  struct sweep_rec *r;
+  struct mu magu;
+  struct ms mags;
+  long long d;
+  
+  for (d = job->first, r = job->recs; d <= job->last; d++, r++)
+  {
+    memset(r, 0, sizeof(*r));
+    r->d = d;
+    if (is_signed == 0)
+    {
+      r->err = kdiv_stats_u(&r->st, (unsigned int)d, width);
+      if ((r->err == KDIV_OK) && (r->st.pow2 == 0))
+      {
+        magu = kdiv_magicu((unsigned int)d, width);
+        r->M = magu.M;
+        r->a = magu.a;
+        r->s = magu.s;
+      }
+    }
+    else
+    {
+      r->err = kdiv_stats_s(&r->st, (int)d, width);
+      if ((r->err == KDIV_OK) && (r->st.muls > 0))
+      {
+        mags = kdiv_magic((int)d, width);
+        // The W-bit pattern of M, as in the certificates of -prove.
+        r->M = (unsigned int)mags.M & (unsigned int)(kdiv_ipowul(2, width) - 1);
+        r->s = mags.s;
+      }
+    }
+  }
+  return (NULL);
 }
 
-/*! Calculate integer power supporting results up to 64-bits.
+/*! Analyze the divisors first..last (at most SWEEP_BLOCK of them) with fn, 
+ *  split across n threads; the result for divisor d is stored in
+ *  recs[d - first], each record being recsize bytes.
  */
-unsigned long long int ipowul(int base, int exponent)
+static void run_block(long long first, long long last, void *(*fn)(void *),
+  void *recs, size_t recsize, struct range_job *jobs, int n)
 {
-  unsigned long long int temp;
+  long long chunk;
   int i;
   
-  temp = 1;
+  chunk = (last - first + n) / n;
+  for (i = 0; i < n; i++)
+  {
+    jobs[i].first = first + i*chunk;
+    jobs[i].last  = (jobs[i].first + chunk - 1 < last) ? 
+                     jobs[i].first + chunk - 1 : last;
+    jobs[i].recs  = (char *)recs + i*chunk*recsize;
+  }
+  run_parallel(fn, jobs, sizeof(struct range_job), n);
+}
+
+/*! Print one line of a sweep histogram.
+ */
+static void print_share(const char *label, long long count, long long total)
+{
+  printf("%-8s %12lld (%6.2f%%)\n", label, count, 
+    (total > 0) ? 100.0 * count / total : 0.0);
+}
+
+/*! Analyze the routines of all divisors in [dlo, dhi] in parallel and print 
+ *  either a CSV line per divisor or a summary histogram.
+ */
+static int run_sweep(void)
+{
+  struct sweep_rec *recs;
+  struct range_job *jobs;
+  long long first, last, total=0, pow2=0, add=0, fixup=0, shift=0;
+  long long ops[SWEEP_MAXOPS+1], depth[SWEEP_MAXOPS+1];
+  int n, i;
+  char label[16];
+  
+  if (dlo > dhi)
+  {
+    fprintf(stderr, "Error: Empty divisor range.\n");
+    return (1);
+  }
+  n = get_nthreads();
+  recs = malloc(SWEEP_BLOCK * sizeof(struct sweep_rec));
+  jobs = malloc(n * sizeof(struct range_job));
+  memset(ops, 0, sizeof(ops));
+  memset(depth, 0, sizeof(depth));
   
-  for (i = 0; i < exponent; i++)
+  if (enable_csv == 1)
+  {
+    printf("divisor,M,a,s,pow2,add,fixup,shift,muls,ops,depth\n");
+  }
+  for (first = dlo; first <= dhi; first = last + 1)
   {
-    temp *= (unsigned int)base;     
+    last  = (dhi - first >= SWEEP_BLOCK) ? first + SWEEP_BLOCK - 1 : dhi;
+    run_block(first, last, sweep_worker, recs, sizeof(struct sweep_rec), 
+      jobs, n);
+    
+    for (i = 0; i <= last - first; i++)
+    {
+      struct sweep_rec *r = &recs[i];
+      if (r->err != KDIV_OK)
+      {
+        continue;
+      }
+      total++;
+      pow2  += r->st.pow2;
+      add   += r->st.add;
+      fixup += r->st.fixup;
+      shift += r->st.shift;
+      ops[(r->st.ops < SWEEP_MAXOPS) ? r->st.ops : SWEEP_MAXOPS]++;
+      depth[(r->st.depth < SWEEP_MAXOPS) ? r->st.depth : SWEEP_MAXOPS]++;
+      if (enable_csv == 1)
+      {
+        printf("%lld,%u,%d,%d,%d,%d,%d,%d,%d,%d,%d\n", r->d, r->M, r->a, r->s,
+          r->st.pow2, r->st.add, r->st.fixup, r->st.shift, r->st.muls,
+          r->st.ops, r->st.depth);
+      }
+    }
   }
+  
+  if (enable_csv == 0)
+  {
+    printf("Divisors %lld..%lld, width %d, %s division: %lld routines\n",
+      dlo, dhi, width, (is_signed == 0) ? "unsigned" : "signed", total);
+    print_share("pow2", pow2, total);
+    print_share("add", add, total);
+    print_share("fixup", fixup, total);
+    print_share("shift", shift, total);
+    printf("ops histogram:\n");
+    for (i = 0; i <= SWEEP_MAXOPS; i++)
+    {
+      if (ops[i] > 0)
+      {
+        sprintf(label, "  %d", i);
+        print_share(label, ops[i], total);
+      }
+    }
+    printf("depth histogram:\n");
+    for (i = 0; i <= SWEEP_MAXOPS; i++)
+    {
+      if (depth[i] > 0)
+      {
+        sprintf(label, "  %d", i);
+        print_share(label, depth[i], total);
+      }
+    }
+  }
+  free(jobs);
+  free(recs);
+  return (0);
+}
 
-  return (temp);
+/*! Proof thread body: prove the routines of one share of a block.
+ */
+static void *prove_worker(void *arg)
+{
+  struct range_job *job = arg;
+  struct kdiv_cert *c;
+  long long d;
+  int err;
+  
+  for (d = job->first, c = job->recs; d <= job->last; d++, c++)
+  {
+    if (is_signed == 0)
+    {
+      err = kdiv_prove_u(c, (unsigned int)d, width);
+    }
+    else
+    {
+      err = kdiv_prove_s(c, (int)d, width);
+    }
+    if ((err != KDIV_OK) && (err != KDIV_E_PROOF))
+    {
+      // Divisors without a routine (zero) are left out of the certificate.
+      c->d  = 0;
+      c->ok = -1;
+    }
+  }
+  return (NULL);
 }
 
-/*! Calculates the multiplicative inverse of an integer divisor for unsigned
- *  division.
+/*! Prove the routines of all divisors in [dlo, dhi] in parallel, writing a
+ *  certificate line per divisor to the named file.
  */
-struct mu magicu(unsigned d, unsigned W) {
-                           // Must have 1 <= d <= 2**32-1.
-   int p;
-   unsigned nc, delta, q1, r1, q2, r2;
-   struct mu magu;
+static int run_prove(const char *fname)
+{
+  struct kdiv_cert *certs;
+  struct range_job *jobs;
+  struct kdiv_buf b;
+  long long first, last, total=0, failed=0;
+  char *data;
+  FILE *fout;
+  int n, i;
+  
+  if (dlo > dhi)
+  {
+    fprintf(stderr, "Error: Empty divisor range.\n");
+    return (1);
+  }
+  fout = fopen(fname, "w");
+  if (fout == NULL)
+  {
+    fprintf(stderr, "Error: Cannot open file %s for writing.\n", fname);
+    return (1);
+  }
+  n = get_nthreads();
+  certs = malloc(SWEEP_BLOCK * sizeof(struct kdiv_cert));
+  jobs  = malloc(n * sizeof(struct range_job));
+  data  = malloc(256);
+  
+  fprintf(fout, "# kdiv certificate: %s division, width %d, divisors %lld..%lld\n",
+    (is_signed == 0) ? "unsigned" : "signed", width, dlo, dhi);
+  fprintf(fout, "# Bounds (m = effective multiplier, p = %d + s, e = m*|d| - 2^p):\n",
+    width);
+  fprintf(fout, "#   e*nc < 2^p and e*nmax + 2^p*(nmax mod |d|) < 2^p*|d|\n");
+  fprintf(fout, "#   (<= and e > 0 on the rounded-up side nc-)\n");
+  fprintf(fout, "# d M a s p m e nc+ nc- spot result\n");
+  for (first = dlo; first <= dhi; first = last + 1)
+  {
+    last = (dhi - first >= SWEEP_BLOCK) ? first + SWEEP_BLOCK - 1 : dhi;
+    run_block(first, last, prove_worker, certs, sizeof(struct kdiv_cert), 
+      jobs, n);
+    for (i = 0; i <= last - first; i++)
+    {
+      if (certs[i].ok == -1)
+      {
+        continue;
+      }
+      total++;
+      if (certs[i].ok == 0)
+      {
+        failed++;
+        if (enable_errors == 1)
+        {
+          printf("Proof FAILED for divisor %lld (M = %u, s = %d)\n", 
+            certs[i].d, certs[i].M, certs[i].s);
+        }
+      }
+      kdiv_buf_init(&b, data, 256);
+      kdiv_cert_print(&b, &certs[i]);
+      fputs(data, fout);
+    }
+  }
+  fprintf(fout, "# %lld divisors, %lld proven, %lld failed\n", 
+    total, total - failed, failed);
+  fclose(fout);
+  printf("%s division, width %d, divisors %lld..%lld: %lld proven, %lld failed\n",
+    (is_signed == 0) ? "unsigned" : "signed", width, dlo, dhi, 
+    total - failed, failed);
+  printf("Certificate written to %s\n", fname);
+  free(data);
+  free(jobs);
+  free(certs);
+  return ((failed == 0) ? 0 : 1);
+}
+
+/* Arguments of the modular multiplication file emitters. */
+struct kmod_args {
+  struct kmod k;
+  const char *kname;
+};
 
-   magu.a = 0;             // Initialize "add" indicator.
-   nc = -1 - (-d)%d;       // Unsigned arithmetic here.
-   p = W-1;                // Init. p.
-
-   q1 = (1 << (W-1))/nc;   // Init. q1 = 2**p/nc.
-   r1 = (1 << (W-1)) - q1*nc;// Init. r1 = rem(2**p, nc).
-   q2 = ((1 << (W-1))-1)/d;      // Init. q2 = (2**p - 1)/d.
-   r2 = ((1 << (W-1))-1) - q2*d; // Init. r2 = rem(2**p - 1, d).
-   do {
-      p = p + 1;
-      if (r1 >= nc - r1) {
-         q1 = 2*q1 + 1;            // Update q1.
-         r1 = 2*r1 - nc;}          // Update r1.
-      else {
-         q1 = 2*q1;
-         r1 = 2*r1;}
-      if (r2 + 1 >= d - r2) {
-         if (q2 >= (unsigned)((1 << (W-1))-1)) magu.a = 1;
-         q2 = 2*q2 + 1;            // Update q2.
-         r2 = 2*r2 + 1 - d;}       // Update r2.
-      else {
-         if (q2 >= (unsigned)(1 << (W-1))) magu.a = 1;
-         q2 = 2*q2;
-         r2 = 2*r2 + 1;}
-      delta = d - 1 - r2;
-   } while (p < 2*(int)W &&
-           (q1 < delta || (q1 == delta && r1 == 0)));
-
-   magu.M = q2 + 1;        // Magic number
-   magu.s = p - W;         // and shift amount to return
-   return magu;            // (magu.a was set above).
-}
-
-/*! Calculates the multiplicative inverse of an integer divisor for signed
- *  division.
- */
-struct ms magic(int d, unsigned W) {   // Must have 2 <= d <= 2**31-1
-                                       // or   -2**31 <= d <= -2.
-   int p;
-   unsigned ad, anc, delta, q1, r1, q2, r2, t;
-   const unsigned two31 = (1 << (W-1));     // 2**31.
-   struct ms mag;
-
-   ad = abs(d);
-   t = (1 << (W-1)) + ((unsigned)d >> (W-1));
-   anc = t - 1 - t%ad;     // Absolute value of nc.
-   p = W-1;                // Init. p.
-   q1 = two31/anc;         // Init. q1 = 2**p/|nc|.
-   r1 = two31 - q1*anc;    // Init. r1 = rem(2**p, |nc|).
-   q2 = two31/ad;          // Init. q2 = 2**p/|d|.
-   r2 = two31 - q2*ad;     // Init. r2 = rem(2**p, |d|).
-   do {
-      p = p + 1;
-      q1 = 2*q1;           // Update q1 = 2**p/|nc|.
-      r1 = 2*r1;           // Update r1 = rem(2**p, |nc|).
-      if (r1 >= anc) {     // (Must be an unsigned
-         q1 = q1 + 1;      // comparison here).
-         r1 = r1 - anc;}
-      q2 = 2*q2;           // Update q2 = 2**p/|d|.
-      r2 = 2*r2;           // Update r2 = rem(2**p, |d|).
-      if (r2 >= ad) {      // (Must be an unsigned
-         q2 = q2 + 1;      // comparison here).
-         r2 = r2 - ad;}
-      delta = ad - r2;
-   } while (q1 < delta || (q1 == delta && r1 == 0));
-
-   mag.M = q2 + 1;
-   if (d < 0) mag.M = -mag.M; // Magic number and
-   mag.s = p - W;             // shift amount to return.
-   return mag;
-}
-
-/*! 
-   NOTES on unsigned division by constant.
-1) Unsigned division by powers-of-2, with d = 2^k
-  shr   q, n, k
-
-2) Unsigned division with a = 0 (additive factor)
-  li    M, dinv             // dinv = multiplicative inverse of d 
-  mulhu q, M, n
-  shri  q, q, s             // s is the shift factor
-  
-3) Unsigned division with a = 1
-  li    M, dinv
-  mulhu q, M, n
-  add   q, q, n
-  shrxi q, q, s             // an extended shr immediate using the carry and 
-                            // q (concatenated); then performing logical shift
-*/     
-
-/*! Emit the NAC (generic assembly language) implementation of unsigned division 
- *  by constant.
- */
-void emit_kdivu_nac(FILE *f, unsigned int M, int a, int s, unsigned int d, unsigned int W)
-{ 
-  pfprintf(f, 0, "procedure kdiv_u%d_p_%d (in u%d n, out u%d y)\n", 
-    W, d, W, W);
-  pfprintf(f, 0, "{\n");   
-  pfprintf(f, 2, "localvar u%d q, M;\n", W);   
-  pfprintf(f, 2, "localvar u%d t0, t1;\n", 2*W);   
-  if (a == 1)
-  {
-    pfprintf(f, 2, "localvar u%d n0;\n", 2*W);   
-  }
-  pfprintf(f, 0, "S_1:\n");
-  
-  if (ispowof2(d) == 1)
-  {
-    // shr   q, n, k
-    pfprintf(f, 2, "q <= shr n, %d;\n", log2ceil(d));
-  }
-  else if (a == 0)
-  {
-    pfprintf(f, 2, "M <= ldc %u;\n", M);
-    // mulhu q, M, n
-    pfprintf(f, 2, "t0 <= mul M, n;\n");
-    pfprintf(f, 2, "t1 <= shr t0, %d;\n", W);
-    pfprintf(f, 2, "q <= trunc t1;\n");
-    // shri  q, q, s
-    pfprintf(f, 2, "q <= shr q, %d;\n", s);
-  }
-  else if (a == 1)
-  {
-    pfprintf(f, 2, "M <= ldc %u;\n", M);
-    // mulhu q, M, n
-    pfprintf(f, 2, "t0 <= mul M, n;\n");
-    pfprintf(f, 2, "t1 <= shr t0, %d;\n", W);
-    pfprintf(f, 2, "q <= trunc t1;\n");
-    // add   q, q, n
-    // t = q + n;
-    // q = t & 0xFFFFFFFF;
-    pfprintf(f, 2, "t0 <= zxt q;\n");
-    pfprintf(f, 2, "n0 <= zxt n;\n");
-    pfprintf(f, 2, "t0 <= add t0, n0;\n");
-    pfprintf(f, 2, "q <= trunc t0;\n");    
-    // shrxi q, q, s        // an extended shr immediate using the carry and 
-                            // q (concatenated); then performing logical shift  
-    pfprintf(f, 2, "q <= shr q, %d;\n", s);
+/*! Emit the Barrett and (for odd moduli) Montgomery kernels.
+ */
+static int kdiv_emit_kmod_file(struct kdiv_buf *b, const void *arg)
+{
+  const struct kmod_args *ka = arg;
+  int err;
+  
+  if (enable_ansic == 1)
+  {
+    err = kdiv_emit_kmod_barrett_ansic(b, &ka->k, width);
+    if ((err == KDIV_OK || err == KDIV_E_NOSPACE) && (ka->k.mont == 1))
+    {
+      err = kdiv_emit_kmod_mont_ansic(b, &ka->k, width);
+    }
   }
   else
   {
-    fprintf(stderr, "Error: Unsupported constant division.\n");
-    exit(1);
-  }  
-  pfprintf(f, 2, "y <= mov q;\n");
-  pfprintf(f, 0, "}\n"); 
+    err = kdiv_emit_kmod_barrett_nac(b, &ka->k, width);
+    if ((err == KDIV_OK || err == KDIV_E_NOSPACE) && (ka->k.mont == 1))
+    {
+      err = kdiv_emit_kmod_mont_nac(b, &ka->k, width);
+    }
+  }
+  return (err);
+}
+
+/*! Emit the benchmark driver of the kernels.
+ */
+static int kdiv_emit_kmod_bench_file(struct kdiv_buf *b, const void *arg)
+{
+  const struct kmod_args *ka = arg;
+  return (kdiv_emit_kmod_bench_ansic(b, &ka->k, width, ka->kname));
+}
+
+/*! Generate the modular multiplication kernels for the modulus m and, with 
+ *  -d, check the reference calculations against the naive % over [lo, hi].
+ */
+static int run_kmod(unsigned int m)
+{
+  struct kmod_args ka;
+  char fname[64], bname[64];
+  unsigned long long int x, a, b, e, exact, p, base;
+  unsigned int rb, rm, pb, pm;
+  int err, i;
+  
+  err = kdiv_kmod(&ka.k, m, width);
+  if (err != KDIV_OK)
+  {
+    fprintf(stderr, "Error: %s\n", kdiv_strerror(err));
+    return (1);
+  }
+  if (ka.k.mont == 0)
+  {
+    fprintf(stderr, "Warning: Montgomery kernels need an odd modulus; only Barrett emitted.\n");
+  }
+  sprintf(fname, "kmod_u%d_%u.%s", width, m, (enable_ansic == 1) ? "c" : "nac");
+  ka.kname = fname;
+  if (emit_file(fname, kdiv_emit_kmod_file, &ka) != 0)
+  {
+    return (1);
+  }
+  if ((enable_bench == 1) && (enable_ansic == 1))
+  {
+    sprintf(bname, "kmod_u%d_%u_bench.c", width, m);
+    if (emit_file(bname, kdiv_emit_kmod_bench_file, &ka) != 0)
+    {
+      return (1);
+    }
+  }
+  
+  if (enable_debug == 1)
+  {
+    for (i = lo; i <= hi; i++)
+    {
+      x = (unsigned int)i * 2654435761U;
+      a = (unsigned int)i % m;
+      b = (unsigned int)x % m;
+      e = (unsigned int)x;
+      exact = a * b % m;
+      rb = kdiv_calculate_mulmod_barrett(&ka.k, a, b);
+      rm = (ka.k.mont == 1) ? kdiv_calculate_redc(&ka.k, 
+             (unsigned long long int)kdiv_calculate_redc(&ka.k, a * b) * ka.k.r2) 
+                            : exact;
+      for (p = 1, base = a; e != 0; e >>= 1, base = base * base % m)
+      {
+        if ((e & 1) != 0)
+        {
+          p = p * base % m;
+        }
+      }
+      pb = kdiv_calculate_powmod_barrett(&ka.k, a, (unsigned int)x);
+      pm = (ka.k.mont == 1) ? kdiv_calculate_powmod_mont(&ka.k, a, (unsigned int)x) 
+                            : p;
+      if ((rb != exact) || (rm != exact) || (pb != p) || (pm != p))
+      {
+        printf("Result NOT exact: %llu*%llu mod %u = %u/%u (%llu), "
+          "%llu^%u mod %u = %u/%u (%llu)\n", a, b, m, rb, rm, exact, 
+          a, (unsigned int)x, m, pb, pm, p);
+      }
+      else if (enable_errors == 0)
+      {
+        printf("%llu*%llu mod %u = %u (%llu), %llu^%u mod %u = %u (%llu)\n", 
+          a, b, m, rb, exact, a, (unsigned int)x, m, pb, p);
+      }
+    }
+  }
+  return (0);
+}
+
+/* Arguments of the dispatch file emitter. */
+struct prof_args {
+  const struct kdiv_prof *hot;
+  int nhot;
+  int table;
+};
+
+/*! Order profile entries by divisor.
+ */
+static int cmp_prof_d(const void *a, const void *b)
+{
+  const struct kdiv_prof *pa = a, *pb = b;
+  return ((pa->d > pb->d) - (pa->d < pb->d));
+}
+
+/*! Order profile entries by decreasing number of calls, then by divisor.
+ */
+static int cmp_prof_count(const void *a, const void *b)
+{
+  const struct kdiv_prof *pa = a, *pb = b;
+  if (pa->count != pb->count)
+  {
+    return ((pa->count < pb->count) ? 1 : -1);
+  }
+  return (cmp_prof_d(a, b));
+}
+
+/*! Emit the dispatch routine of the hot divisors.
+ */
+static int emit_dispatch_file(struct kdiv_buf *b, const void *arg)
+{
+  const struct prof_args *pa = arg;
+  return (kdiv_emit_dispatch_ansic(b, pa->hot, pa->nhot, width, is_signed, 
+    pa->table));
+}
+
+/*! Read a divisor histogram ("divisor count" per line, # for comments), 
+ *  emit the dispatch routine of its nhot most frequent divisors, report the
+ *  expected cost per call and, with -d, check the routines of the hot 
+ *  divisors for dividends in [lo, hi].
+ */
+static int run_profile(const char *hname)
+{
+  FILE *fin;
+  struct kdiv_prof *prof=NULL, *tmp;
+  struct kdiv_dcost cost;
+  struct prof_args pa;
+  struct mu magu;
+  struct ms mags;
+  char line[256], fname[64];
+  long long d;
+  unsigned long long int count, cold=0, total=0;
+  int nprof=0, maxprof=0, n, i, j, err, errors=0, use_div;
+  
+  fin = fopen(hname, "r");
+  if (fin == NULL)
+  {
+    fprintf(stderr, "Error: Cannot open file %s for reading.\n", hname);
+    return (1);
+  }
+  while (fgets(line, sizeof(line), fin) != NULL)
+  {
+    if (sscanf(line, " %lld %llu", &d, &count) != 2)
+    {
+      if ((sscanf(line, " %1s", fname) == 1) && (fname[0] != '#'))
+      {
+        fprintf(stderr, "Warning: Ignoring malformed line in %s: %s", hname, line);
+      }
+      continue;
+    }
+    total = total + count;
+    // Routines take int divisors, so larger unsigned ones are unsupported.
+    err = ((d < -2147483647LL) || (d > 2147483647LL)) ? KDIV_E_UNSUPPORTED
+        : kdiv_check((int)d, width, is_signed);
+    if (err != KDIV_OK)
+    {
+      // Not a valid constant divisor: always handled by div.
+      fprintf(stderr, "Warning: Divisor %lld in %s: %s Counted as cold.\n", 
+        d, hname, kdiv_strerror(err));
+      cold = cold + count;
+      continue;
+    }
+    if (nprof == maxprof)
+    {
+      maxprof = (maxprof == 0) ? 64 : 2*maxprof;
+      tmp = realloc(prof, maxprof * sizeof(struct kdiv_prof));
+      if (tmp == NULL)
+      {
+        fprintf(stderr, "Error: Out of memory.\n");
+        free(prof);
+        fclose(fin);
+        return (1);
+      }
+      prof = tmp;
+    }
+    prof[nprof].d     = (int)d;
+    prof[nprof].count = count;
+    nprof++;
+  }
+  fclose(fin);
+  if (total == 0)
+  {
+    fprintf(stderr, "Error: Empty divisor profile in %s.\n", hname);
+    free(prof);
+    return (1);
+  }
+  
+  // Merge repeated divisors, then rank them by number of calls.
+  if (nprof > 0)
+  {
+    qsort(prof, nprof, sizeof(struct kdiv_prof), cmp_prof_d);
+    for (i = 1, j = 0; i < nprof; i++)
+    {
+      if (prof[i].d == prof[j].d)
+      {
+        prof[j].count = prof[j].count + prof[i].count;
+      }
+      else
+      {
+        prof[++j] = prof[i];
+      }
+    }
+    nprof = j + 1;
+    qsort(prof, nprof, sizeof(struct kdiv_prof), cmp_prof_count);
+  }
+  n = (nprof < nhot) ? nprof : nhot;
+  while ((n > 0) && (prof[n-1].count == 0))
+  {
+    n--;
+  }
+  for (i = n; i < nprof; i++)
+  {
+    cold = cold + prof[i].count;
+  }
+  
+  err = kdiv_dispatch_cost(&cost, prof, n, cold, width, is_signed, divcost);
+  if (err != KDIV_OK)
+  {
+    fprintf(stderr, "Error: %s\n", kdiv_strerror(err));
+    free(prof);
+    return (1);
+  }
+  // Without a hot divisor that pays off, the routine is the plain division.
+  use_div = (n == 0) || ((cost.chain >= cost.div) && (cost.table >= cost.div));
+  pa.hot   = prof;
+  pa.nhot  = (use_div == 1) ? 0 : n;
+  pa.table = (use_div == 1) ? 0 : cost.use_table;
+  sprintf(fname, "kdiv_%c%d_dispatch.c", (is_signed == 0) ? 'u' : 's', width);
+  if (emit_file(fname, emit_dispatch_file, &pa) != 0)
+  {
+    free(prof);
+    return (1);
+  }
+  
+  printf("Profile %s: %llu calls, %d valid divisors, %d hot\n", 
+    hname, total, nprof, n);
+  for (i = 0; i < n; i++)
+  {
+    printf("  %d: %llu calls (%.2f%%)\n", prof[i].d, prof[i].count, 
+      100.0 * prof[i].count / total);
+  }
+  printf("Hot divisors cover %.2f%% of the calls\n", 100.0 * cost.hit);
+  printf("Expected cost per call: chain %.2f, switch %.2f, div only %.2f\n", 
+    cost.chain, cost.table, cost.div);
+  if (use_div == 1)
+  {
+    printf("No dispatch beats hardware division; plain division written to %s\n",
+      fname);
+  }
+  else
+  {
+    printf("Dispatch routine (%s) written to %s\n", 
+      (cost.use_table == 1) ? "switch" : "chain", fname);
+  }
+  
+  if (enable_debug == 1)
+  {
+    for (j = 0; j < pa.nhot; j++)
+    {
+      if (is_signed == 0)
+      {
+        magu = kdiv_magicu(prof[j].d, width);
+      }
+      else
+      {
+        mags = kdiv_magic(prof[j].d, width);
+      }
+      for (i = lo; i <= hi; i++)
+      {
+        if (((is_signed == 0) && 
+             (kdiv_calculate_u(magu.M, magu.a, magu.s, i, prof[j].d, width) != 
+              (unsigned int)i/(unsigned int)prof[j].d)) || 
+            ((is_signed == 1) && 
+             (kdiv_calculate_s(mags.M, mags.s, i, prof[j].d, width) != 
+              i/prof[j].d)))
+        {
+          printf("Result NOT exact: %d/%d\n", i, prof[j].d);
+          errors++;
+        }
+      }
+    }
+    if (enable_errors == 0)
+    {
+      printf("%d hot divisors checked for dividends %d..%d: %d errors\n", 
+        pa.nhot, lo, hi, errors);
+    }
+  }
+  free(prof);
+  return (errors != 0);
+}
+
+/* Arguments of the limb-array division file emitters. */
+struct kbig_args {
+  struct kbig k;
+  const char *kname;
+};
+
+/*! Emit the limb-array division routines.
+ */
+static int kdiv_emit_kbig_file(struct kdiv_buf *b, const void *arg)
+{
+  const struct kbig_args *ka = arg;
+  return (kdiv_emit_kbig_ansic(b, &ka->k));
+}
+
+/*! Emit the benchmark driver of the limb-array division routines.
+ */
+static int kdiv_emit_kbig_bench_file(struct kdiv_buf *b, const void *arg)
+{
+  const struct kbig_args *ka = arg;
+  return (kdiv_emit_kbig_bench_ansic(b, &ka->k, ka->kname));
+}
+
+/*! Check kdiv_calculate_kbig_divrem on the n-limb integer a against schoolbook 
+ *  division with a hardware divide. Returns 1 on a mismatch.
+ */
+static int check_kbig(const struct kbig *k, const unsigned int *a, size_t n)
+{
+  unsigned long long int t;
+  unsigned int q[64], r=0, rk;
+  size_t i;
+  int bad=0;
+  
+  rk = kdiv_calculate_kbig_divrem(k, q, a, n);
+  for (i = n; i-- > 0; )
+  {
+    t = ((unsigned long long int)r << 32) | a[i];
+    bad |= (q[i] != (unsigned int)(t / k->d));
+    r = (unsigned int)(t % k->d);
+  }
+  bad |= (rk != r) || (kdiv_calculate_kbig_divrem(k, NULL, a, n) != r);
+  if ((bad != 0) && (enable_errors == 1))
+  {
+    printf("Result NOT exact: %lu-limb integer with top limb %u / %u\n", 
+      (unsigned long)n, (n > 0) ? a[n-1] : 0, k->d);
+  }
+  return (bad);
+}
+
+/*! Generate the limb-array division routines for the divisor d and, with
+ *  -d, check the reference calculation exhaustively on all integers of up 
+ *  to 3 limbs drawn from boundary values and on the single limbs in 
+ *  [lo, hi], and on random integers of up to 64 limbs.
+ */
+static int run_kbig(unsigned int d)
+{
+  struct kbig_args ka;
+  char fname[64], bname[64];
+  unsigned int edge[12], a[64], x=12345;
+  int err, n, i, j, idx, total=0, errors=0;
+  
+  err = kdiv_kbig(&ka.k, d);
+  if (err != KDIV_OK)
+  {
+    fprintf(stderr, "Error: %s\n", kdiv_strerror(err));
+    return (1);
+  }
+  sprintf(fname, "kbig_u32_%u.c", d);
+  ka.kname = fname;
+  if (emit_file(fname, kdiv_emit_kbig_file, &ka) != 0)
+  {
+    return (1);
+  }
+  if (enable_bench == 1)
+  {
+    sprintf(bname, "kbig_u32_%u_bench.c", d);
+    if (emit_file(bname, kdiv_emit_kbig_bench_file, &ka) != 0)
+    {
+      return (1);
+    }
+  }
+  
+  if (enable_debug == 1)
+  {
+    edge[0]  = 0;
+    edge[1]  = 1;
+    edge[2]  = d - 1;
+    edge[3]  = d;
+    edge[4]  = d + 1;
+    edge[5]  = ka.k.dn - 1;
+    edge[6]  = ka.k.dn;
+    edge[7]  = ~ka.k.dn;
+    edge[8]  = 0x7FFFFFFFU;
+    edge[9]  = 0x80000000U;
+    edge[10] = 0xFFFFFFFEU;
+    edge[11] = 0xFFFFFFFFU;
+    for (n = 0; n <= 3; n++)
+    {
+      for (idx = 0; idx < ((n == 0) ? 1 : (n == 1) ? 12 : (n == 2) ? 144 : 1728); idx++)
+      {
+        for (i = 0, j = idx; i < n; i++, j /= 12)
+        {
+          a[i] = edge[j % 12];
+        }
+        errors += check_kbig(&ka.k, a, n);
+        total++;
+      }
+    }
+    for (i = lo; i <= hi; i++)
+    {
+      a[0] = (unsigned int)i;
+      a[1] = (unsigned int)i * 2654435761U;
+      errors += check_kbig(&ka.k, a, 1) + check_kbig(&ka.k, a, 2);
+      total += 2;
+    }
+    for (i = 0; i < 10000; i++)
+    {
+      n = 1 + i % 64;
+      for (j = 0; j < n; j++)
+      {
+        x = x * 1664525U + 1013904223U;
+        a[j] = x;
+      }
+      errors += check_kbig(&ka.k, a, n);
+      total++;
+    }
+    if (enable_errors == 0)
+    {
+      printf("kbig_u32_%u: %d integers checked, %d errors\n", d, total, errors);
+    }
+  }
+  return (errors != 0);
+}
+
+/* Floating-point lowering of the divisor and its routine file name. */
+struct kfp_args {
+  struct kdiv_fp fp;
+  const char *kname;
+};
+
+/*! Emit the scalar and array routines of the floating-point lowering.
+ */
+static int emit_fp_file(struct kdiv_buf *b, const void *arg)
+{
+  const struct kfp_args *ka = arg;
+  return (kdiv_emit_fp_ansic(b, &ka->fp));
+}
+
+/*! Emit the benchmark driver of the floating-point lowering.
+ */
+static int emit_fp_bench_file(struct kdiv_buf *b, const void *arg)
+{
+  const struct kfp_args *ka = arg;
+  return (kdiv_emit_fp_bench_ansic(b, &ka->fp, ka->kname));
+}
+
+/*! Generate the floating-point lowering of the divisor, proven over the 
+ *  dividends of the width or, if -lo/-hi are given, of [lo, hi]. With 
+ *  -stats, compare its cost to the integer routine and, with -d, check the 
+ *  reference calculation over the proven part of [lo, hi].
+ */
+static int run_fp(void)
+{
+  struct kfp_args ka;
+  struct kdiv_spec spec;
+  struct kdiv_stats si, sf;
+  struct kdiv_buf name;
+  char name_data[64], fname[80], bname[96];
+  unsigned long long int nmax=0;
+  long long q;
+  int err, i, use_fp, total=0, errors=0;
+  
+  if (has_nrange == 1)
+  {
+    if ((lo > hi) || ((is_signed == 0) && (lo < 0)))
+    {
+      fprintf(stderr, "Error: %s\n", kdiv_strerror(KDIV_E_RANGE));
+      return (1);
+    }
+    nmax = (unsigned long long int)((-(long long)lo > hi) ? -(long long)lo : hi);
+    nmax = (nmax == 0) ? 1 : nmax;
+  }
+  err = kdiv_fp(&ka.fp, divisor, width, is_signed, nmax);
+  if (err != KDIV_OK)
+  {
+    fprintf(stderr, "Error: %s\n", kdiv_strerror(err));
+    return (1);
+  }
+  spec.divisor   = divisor;
+  spec.width     = width;
+  spec.is_signed = is_signed;
+  spec.lang      = KDIV_LANG_ANSIC;
+  spec.mulwidth  = 0;
+  kdiv_buf_init(&name, name_data, sizeof(name_data));
+  kdiv_routine_name(&name, &spec);
+  sprintf(fname, "%s_fp.c", name_data);
+  ka.kname = fname;
+  if (emit_file(fname, emit_fp_file, &ka) != 0)
+  {
+    return (1);
+  }
+  printf("%s_fp: %s reciprocal %s0x%llXp-%d, exact for |n| <= %llu\n", 
+    name_data, (ka.fp.dbl == 1) ? "double" : "float", (divisor < 0) ? "-" : "",
+    ka.fp.mc, ka.fp.S, ka.fp.nmax);
+  if (enable_bench == 1)
+  {
+    // The benchmark includes the ANSI C integer routine (32-bit int).
+    if (width != 32)
+    {
+      fprintf(stderr, "Error: -bench with -fp supports only width=32.\n");
+      return (1);
+    }
+    sprintf(bname, "%s_fp_bench.c", name_data);
+    if (emit_file(bname, emit_fp_bench_file, &ka) != 0)
+    {
+      return (1);
+    }
+  }
+  
+  if (enable_stats == 1)
+  {
+    if (is_signed == 0)
+    {
+      kdiv_stats_u(&si, divisor, width);
+    }
+    else
+    {
+      kdiv_stats_s(&si, divisor, width);
+    }
+    kdiv_stats_fp(&sf, &ka.fp);
+    print_stats(stdout, name_data, &si);
+    sprintf(bname, "%s_fp", name_data);
+    print_stats(stdout, bname, &sf);
+    // By latency, then operations; ties go to the form that keeps the 
+    // integer multiplier free. The throughput gain of the fp form on a 
+    // saturated integer multiplier is not modelled: -bench measures it.
+    use_fp = (sf.lat < si.lat) || 
+             ((sf.lat == si.lat) && ((sf.ops < si.ops) || 
+                                     ((sf.ops == si.ops) && (si.muls > 0))));
+    printf("%s: latency %d (integer) vs %d (fp) cycles, cost model prefers the %s form\n", 
+      name_data, si.lat, sf.lat, (use_fp == 1) ? "fp" : "integer");
+  }
+  
+  if (enable_debug == 1)
+  {
+    for (i = lo; i <= hi; i++)
+    {
+      if (((i < 0) && ((unsigned long long int)(-(long long)i) > ka.fp.nmax)) ||
+          ((i >= 0) && ((unsigned long long int)i > ka.fp.nmax)) ||
+          ((i == -2147483647-1) && (divisor == -1)))
+      {
+        continue;
+      }
+      q = kdiv_calculate_fp(&ka.fp, i);
+      total++;
+      if (q != (long long)i / divisor)
+      {
+        errors++;
+        if (enable_errors == 1)
+        {
+          printf("Result NOT exact: %d/%d = %lld (%lld)\n", 
+            i, divisor, q, (long long)i / divisor);
+        }
+      }
+    }
+    if (enable_errors == 0)
+    {
+      printf("%s_fp: %d dividends checked, %d errors\n", name_data, total, 
+        errors);
+    }
+  }
+  return (errors != 0);
+}
+
+/* Dictionary of per-lane divisors and its routine file name. */
+struct kdict_args {
+  struct kdiv_lane *l;
+  int nl;
+  const char *kname;
+};
+
+/* Check of the dictionary routines over one share of the dividends. */
+struct dict_job {
+  long long first, last;
+  const struct kdiv_lane *l;
+  int nl;
+  unsigned long long int bad[256];
+};
+
+/*! Emit the tables, scalar and array routines of the dictionary.
+ */
+static int emit_dict_file(struct kdiv_buf *b, const void *arg)
+{
+  const struct kdict_args *ka = arg;
+  return (kdiv_emit_dict_ansic(b, ka->l, ka->nl, is_signed));
+}
+
+/*! Emit the benchmark driver of the dictionary routines.
+ */
+static int emit_dict_bench_file(struct kdiv_buf *b, const void *arg)
+{
+  const struct kdict_args *ka = arg;
+  return (kdiv_emit_dict_bench_ansic(b, ka->l, ka->nl, is_signed, ka->kname));
+}
+
+/*! Dictionary check thread body: compare the per-lane calculation of every 
+ *  divisor with the reference one for the dividends of one share.
+ */
+static void *dict_worker(void *arg)
+{
+  struct dict_job *job = arg;
+  struct mu magu;
+  struct ms mags;
+  long long n;
+  int k, d;
+  
+  for (k = 0; k < job->nl; k++)
+  {
+    d = job->l[k].d;
+    job->bad[k] = 0;
+    if (is_signed == 0)
+    {
+      magu = kdiv_magicu(d, 32);
+      for (n = job->first; n <= job->last; n++)
+      {
+        job->bad[k] += (kdiv_calculate_u_lane(&job->l[k], (unsigned int)n) != 
+          kdiv_calculate_u(magu.M, magu.a, magu.s, (unsigned int)n, d, 32));
+      }
+    }
+    else
+    {
+      mags = kdiv_magic(d, 32);
+      for (n = job->first; n <= job->last; n++)
+      {
+        job->bad[k] += (kdiv_calculate_s_lane(&job->l[k], (int)n) != 
+          kdiv_calculate_s(mags.M, mags.s, (int)n, d, 32));
+      }
+    }
+  }
+  return (NULL);
+}
+
+/*! Read a dictionary of divisors (one per line, the first number of the 
+ *  line) and emit kdiv_<u|s>32_dict.c with its per-lane routines, where 
+ *  divisor i is the i-th of the file. With -d, check the per-lane 
+ *  calculation against the reference one for the dividends in [lo, hi] 
+ *  or, without -lo/-hi, for all 2^32 dividends in parallel.
+ */
+static int run_dict(const char *dname)
+{
+  FILE *fin;
+  struct kdiv_lane l[256];
+  struct kdict_args ka;
+  struct dict_job *jobs;
+  char line[256], fname[64], bname[72];
+  long long d, first, last, chunk;
+  unsigned long long int bad, total, errors=0;
+  int nl=0, n, i, k, err;
+  
+  fin = fopen(dname, "r");
+  if (fin == NULL)
+  {
+    fprintf(stderr, "Error: Cannot open file %s for reading.\n", dname);
+    return (1);
+  }
+  while (fgets(line, sizeof(line), fin) != NULL)
+  {
+    if (sscanf(line, " %lld", &d) != 1)
+    {
+      if ((sscanf(line, " %1s", fname) == 1) && (fname[0] != '#'))
+      {
+        fprintf(stderr, "Warning: Ignoring malformed line in %s: %s", dname, line);
+      }
+      continue;
+    }
+    if (nl == 256)
+    {
+      fprintf(stderr, "Error: More than 256 divisors in %s.\n", dname);
+      fclose(fin);
+      return (1);
+    }
+    err = ((d < -2147483647LL) || (d > 2147483647LL)) ? KDIV_E_RANGE 
+        : kdiv_lane(&l[nl], (int)d, is_signed);
+    if (err != KDIV_OK)
+    {
+      fprintf(stderr, "Error: Divisor %lld: %s\n", d, kdiv_strerror(err));
+      fclose(fin);
+      return (1);
+    }
+    nl++;
+  }
+  fclose(fin);
+  if (nl == 0)
+  {
+    fprintf(stderr, "Error: Empty divisor dictionary in %s.\n", dname);
+    return (1);
+  }
+  
+  ka.l  = l;
+  ka.nl = nl;
+  sprintf(fname, "kdiv_%c32_dict.c", (is_signed == 0) ? 'u' : 's');
+  ka.kname = fname;
+  if (emit_file(fname, emit_dict_file, &ka) != 0)
+  {
+    return (1);
+  }
+  printf("Dictionary %s: %d divisors, routines written to %s\n", dname, nl, 
+    fname);
+  if (enable_bench == 1)
+  {
+    sprintf(bname, "kdiv_%c32_dict_bench.c", (is_signed == 0) ? 'u' : 's');
+    if (emit_file(bname, emit_dict_bench_file, &ka) != 0)
+    {
+      return (1);
+    }
+  }
+  
+  if (enable_debug == 1)
+  {
+    if (has_nrange == 1)
+    {
+      first = lo;
+      last  = hi;
+    }
+    else
+    {
+      first = (is_signed == 0) ? 0 : -2147483648LL;
+      last  = (is_signed == 0) ? 4294967295LL : 2147483647LL;
+    }
+    if (first > last)
+    {
+      fprintf(stderr, "Error: %s\n", kdiv_strerror(KDIV_E_RANGE));
+      return (1);
+    }
+    n = get_nthreads();
+    jobs = malloc(n * sizeof(struct dict_job));
+    chunk = (last - first + n) / n;
+    for (i = 0; i < n; i++)
+    {
+      jobs[i].first = first + i*chunk;
+      jobs[i].last  = (jobs[i].first + chunk - 1 < last) ? 
+                       jobs[i].first + chunk - 1 : last;
+      jobs[i].l     = l;
+      jobs[i].nl    = nl;
+    }
+    run_parallel(dict_worker, jobs, sizeof(struct dict_job), n);
+    total = (unsigned long long int)(last - first + 1);
+    for (k = 0; k < nl; k++)
+    {
+      for (i = 0, bad = 0; i < n; i++)
+      {
+        bad = bad + jobs[i].bad[k];
+      }
+      if ((bad != 0) && (enable_errors == 1))
+      {
+        printf("Per-lane result NOT exact for divisor %d: %llu dividends\n", 
+          l[k].d, bad);
+      }
+      errors = errors + bad;
+    }
+    free(jobs);
+    if (enable_errors == 0)
+    {
+      printf("kdiv_%c32_dict: %d divisors x %llu dividends checked, %llu errors\n", 
+        (is_signed == 0) ? 'u' : 's', nl, total, errors);
+    }
+  }
+  return (errors != 0);
 }
 
-/*! Emit the ANSI C implementation of unsigned division by constant.
- */                       
-void emit_kdivu_ansic(FILE *f, unsigned int M, int a, int s, unsigned int d, unsigned int W)
+/* Routine of the divisor and the number of interleaved lanes. */
+struct kbatch_args {
+  struct kdiv_spec spec;
+  int N;
+};
+
+/*! Emit the interleaved batch routine.
+ */
+static int emit_batch_file(struct kdiv_buf *b, const void *arg)
+{
+  const struct kbatch_args *ka = arg;
+  return (kdiv_emit_batch_ansic(b, &ka->spec, ka->N));
+}
+
+/*! Emit the benchmark driver of the batch routines.
+ */
+static int emit_batch_bench_file(struct kdiv_buf *b, const void *arg)
+{
+  const struct kbatch_args *ka = arg;
+  return (kdiv_emit_batch_bench_ansic(b, &ka->spec));
+}
+
+/*! Emit <name>_x<N>.c with the N-way interleaved batch routine of spec and,
+ *  with -bench, <name>_batch_bench.c timing it against the single-value 
+ *  routine.
+ */
+static int run_batch(const struct kdiv_spec *spec, const char *name)
 {
-  pfprintf(f, 0, "unsigned int kdiv_u%d_p_%d (unsigned int n)\n", W, d);
-  pfprintf(f, 0, "{\n");   
-  pfprintf(f, 2, "unsigned int q, M=%u;\n", M);   
-  pfprintf(f, 2, "unsigned long long int t;\n");   
+  struct kbatch_args ka;
+  char fname[80];
   
-  if (ispowof2(d) == 1)
+  ka.spec = *spec;
+  ka.N = batch;
+  sprintf(fname, "%s_x%d.c", name, batch);
+  if (emit_file(fname, emit_batch_file, &ka) != 0)
   {
-    pfprintf(f, 2, "q = n >> %d;\n", log2ceil(d));
+    return (1);
   }
-  else if (a == 0)
+  if (enable_bench == 1)
   {
-    // mulhu q, M, n
-    pfprintf(f, 2, "t = (unsigned long long int)M * (unsigned long long int)n;\n");
-    pfprintf(f, 2, "q = t >> %d;\n", W);
-    if (s > 0)
+    sprintf(fname, "%s_batch_bench.c", name);
+    if (emit_file(fname, emit_batch_bench_file, &ka) != 0)
     {
-      // shri  q, q, s
-      pfprintf(f, 2, "q = q >> %d;\n", s);
+      return (1);
     }
   }
-  else if (a == 1)
-  {
-    // mulhu q, M, n
-    pfprintf(f, 2, "t = (unsigned long long int)M * (unsigned long long int)n;\n");
-    pfprintf(f, 2, "q = t >> %d;\n", W);    
-    // add   q, q, n
-    pfprintf(f, 2, "t = q + n;\n");
-    pfprintf(f, 2, "q = t & %d;\n", ipowul(2, W)-1);
-    // shrxi q, q, s        // an extended shr immediate using the carry and 
-                            // q (concatenated); then performing logical shift  
-    if (s > 0)
-    {
-      pfprintf(f, 2, "q = t >> %d;\n", s);
-    }
-  }
-  else
-  {
-    fprintf(stderr, "Error: Unsupported constant division.\n");
-    exit(1);
-  }  
-  pfprintf(f, 2, "return (q);\n");
-  pfprintf(f, 0, "}\n");
+  return (0);
 }
 
-/*! Perform an unsigned division by constant according to "Hacker's Delight"
- *  routines.
+/* Check of the compiled routine over one share of the dividends. */
+struct selftest_job {
+  long long first, last;
+  void (*fn)(unsigned int *, unsigned int, unsigned int);
+  unsigned long long int bad;
+  long long badn[SELFTEST_NBAD];
+  unsigned int badq[SELFTEST_NBAD], bade[SELFTEST_NBAD];
+  double trout, thw;
+};
+
+/* Divisor of the hardware division, hidden from the optimizer. */
+volatile int selftest_divisor;
+
+/*! Return the nanoseconds from t0 to t1.
  */
-unsigned int calculate_kdivu(unsigned int M, int a, int s, unsigned int n, unsigned int d, unsigned int W)
+static double elapsed_ns(const struct timespec *t0, const struct timespec *t1)
 {
-  unsigned long long int t;
-  unsigned int q;
-  
-  if (ispowof2(d) == 1)
-  {
-    // shr   q, n, k
-    q = n >> log2ceil(d);  // NOTE: log2ceil() accepts int and not unsigned int.
-  }
-  else if (a == 0)
-  {
-    // mulhu q, M, n
-    t = (unsigned long long int)M * (unsigned long long int)n;
-    q = t >> W;
-    // shri  q, q, s
-    q = q >> s;
-  }
-  else if (a == 1)
-  {
-    // mulhu q, M, n
-    t = (unsigned long long int)M * (unsigned long long int)n;
-    q = t >> W;    
-    // add   q, q, n
-    t = q + n;
-    q = t & (ipowul(2, W) - 1);
-    // shrxi q, q, s        // an extended shr immediate using the carry and 
-                            // q (concatenated); then performing logical shift  
-    q = q >> s;    
-  }
-  else
-  {
-    fprintf(stderr, "Error: Unsupported constant division.\n");
-    exit(1);
-  }  
-  return (q);
+  return (1e9 * (double)(t1->tv_sec - t0->tv_sec) + 
+    (double)(t1->tv_nsec - t0->tv_nsec));
 }
 
-/*!
-   NOTES on signed division by constant.
-4) Signed division for non-powers-of-2
-  li    M, dinv
-  mulhs q, M, n
-  add   q, q, n             // correction term only for d = 7
-  shrsi q, q, s
-  shri  t, n, W-1           // W is the word length
-  add   q, q, t
-  add   q, q, 1             // for negative divisors (d < 0)
-
-5) Signed division by powers-of-2, with d = 2^k
-  shrsi t, n, k-1
-  shri  t, t, W-k
-  add   t, n, t
-  shrsi q, t, k
-  neg   q, q                // for negative divisors (d < 0)
-*/     
-
-/*! Emit the NAC (generic assembly language) implementation of signed division 
- *  by constant.
- */                       
-void emit_kdivs_nac(FILE *f, int M, int s, int d, unsigned int W)
+/*! Self-test thread body: run the compiled routine and the hardware division
+ *  on blocks of the dividends of one share, timing both, and compare them.
+ */
+static void *selftest_worker(void *arg)
 {
-  int k;
-  
-  pfprintf(f, 0, "procedure kdiv_s%d_", W);
-  if (d < 0)
-  {
-    fprintf(f, "m_");
-  }
-  else
-  {
-    fprintf(f, "p_");
-  }
-  fprintf(f, "%d (in s%u n, out s%u y)\n", 
-    ABS(d), W, W);
-  pfprintf(f, 0, "{\n");   
-  pfprintf(f, 2, "localvar s%u q, M, c;\n", W);   
-  pfprintf(f, 2, "localvar s%u t, u, v;\n", 2*W);   
-  pfprintf(f, 0, "S_1:\n");
+  struct selftest_job *job = arg;
+  unsigned int q[SELFTEST_BLOCK], r[SELFTEST_BLOCK];
+  struct timespec t0, t1, t2;
+  long long first;
+  unsigned int ud, count, i, i0;
+  int sd;
   
-  k = log2ceil(ABS(d));
-  if (d == 1)
-  {
-    // mov q, n
-    pfprintf(f, 2, "q <= mov n;\n");
-  }
-  else if (d == -1)
-  {
-    // neg q, n
-    pfprintf(f, 2, "q <= neg n;\n");
-  }
-  else if (ispowof2(d) == 1)
-  {
-    // shrsi t, n, k-1
-    pfprintf(f, 2, "t <= sxt n;\n");
-    pfprintf(f, 2, "t <= shr t, %d;\n", k-1);   
-    // shri  t, t, W-k
-    pfprintf(f, 2, "u <= shr t, %d;\n", W-k);
-    // add   t, n, t
-    pfprintf(f, 2, "v <= sxt n;\n");
-    pfprintf(f, 2, "t <= add v, u;\n");
-    // shrsi q, t, k
-    pfprintf(f, 2, "t <= shr t, %d;\n", k);
-    pfprintf(f, 2, "q <= trunc t;\n");
-    // neg   q, q                // for negative divisors (d < 0)
-    if (d < 0)
-    {
-      pfprintf(f, 2, "q <= neg q;\n");
-    }
-  }
-  else
+  sd = selftest_divisor;
+  ud = (unsigned int)sd;
+  job->bad = 0;
+  job->trout = 0.0;
+  job->thw = 0.0;
+  for (first = job->first; first <= job->last; first += SELFTEST_BLOCK)
   {
-    pfprintf(f, 2, "M <= ldc %d;\n", M);
-    // mulhs q, M, n
-    pfprintf(f, 2, "t <= mul M, n;\n");    
-    pfprintf(f, 2, "u <= shr t, %d;\n", W);
-    pfprintf(f, 2, "q <= trunc u;\n");    
-    // add|sub  q, q, n             // correction term for certain divisors
-    if ((d > 0) && (M < 0))
-    {
-      pfprintf(f, 2, "q <= add q, n;\n");
-    }    
-    else if ((d < 0) && (M > 0))
+    count = (job->last - first + 1 < SELFTEST_BLOCK) ? 
+            (unsigned int)(job->last - first + 1) : SELFTEST_BLOCK;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    job->fn(q, (unsigned int)first, count);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    if (is_signed == 0)
     {
-      pfprintf(f, 2, "q <= sub q, n;\n");
+      for (i = 0; i < count; i++)
+      {
+        r[i] = ((unsigned int)first + i) / ud;
+      }
     }
-    // shrsi q, q, s
-    if (s > 0)
+    else
     {
-      pfprintf(f, 2, "q <= shr q, %d;\n", s);
+      // -2^31 / -1 overflows (and traps); take the routine's result.
+      i0 = ((sd == -1) && (first == -2147483647LL-1));
+      if (i0 == 1)
+      {
+        r[0] = q[0];
+      }
+      for (i = i0; i < count; i++)
+      {
+        r[i] = (unsigned int)((int)(first + i) / sd);
+      }
     }
-    // shri  t, n, W-1           // W is the word length
-    pfprintf(f, 2, "c <= shr n, %d;\n", W-1);
-    // add   q, q, t
-    pfprintf(f, 2, "q <= add q, c;\n");
-    // add   q, q, 1             // for negative divisors (d < 0) and (n != 0)
-    if (d < 0)
+    clock_gettime(CLOCK_MONOTONIC, &t2);
+    job->trout += elapsed_ns(&t0, &t1);
+    job->thw   += elapsed_ns(&t1, &t2);
+    for (i = 0; i < count; i++)
     {
-      pfprintf(f, 2, "c <= setne n, 0;\n");
-      pfprintf(f, 2, "q <= add q, c;\n");
+      if (q[i] != r[i])
+      {
+        if (job->bad < SELFTEST_NBAD)
+        {
+          job->badn[job->bad] = first + i;
+          job->badq[job->bad] = q[i];
+          job->bade[job->bad] = r[i];
+        }
+        job->bad++;
+      }
     }
   }
-  pfprintf(f, 2, "y <= mov q;\n");
-  pfprintf(f, 0, "}\n"); 
+  return (NULL);
 }
 
-/*! Emit the ANSI C implementation of signed division by constant.
- */  
-void emit_kdivs_ansic(FILE *f, int M, int s, int d, unsigned int W)
+/*! Compile the emitted routine <name>.c, through the harness of 
+ *  kdiv_emit_selftest_ansic, into a shared object with the command of -cc, 
+ *  load it and compare it with hardware division for the dividends in 
+ *  [lo, hi] or, without -lo/-hi, for all 2^32 dividends in parallel. The 
+ *  harness and the shared object are removed afterwards.
+ */
+static int run_selftest(const struct kdiv_spec *spec, const char *name)
 {
-  int k;
+  struct selftest_job *jobs;
+  struct timespec t0, t1;
+  struct kdiv_buf b;
+  void *so;
+  char kname[72], hname[80], soname[80], sym[80], data[1024], *cmd;
+  long long first, last, chunk;
+  unsigned long long int total, bad=0;
+  double trout=0.0, thw=0.0, wall;
+  int n, i, j, ret;
   
-  pfprintf(f, 0, "signed int kdiv_s%d_", W);
-  if (d < 0)
+  if (has_nrange == 1)
   {
-    fprintf(f, "m_");
+    first = lo;
+    last  = hi;
   }
   else
   {
-    fprintf(f, "p_");
+    first = (is_signed == 0) ? 0 : -2147483647LL-1;
+    last  = (is_signed == 0) ? 4294967295LL : 2147483647LL;
   }
-  fprintf(f, "%d (signed int n)\n", ABS(d));
-  pfprintf(f, 0, "{\n");   
-  pfprintf(f, 2, "signed int q, M=%d, c;\n", M);   
-  pfprintf(f, 2, "signed long long int t, u, v;\n");   
-
-  k = log2ceil(ABS(d));
-  if (d == 1)
+  if ((first > last) || ((is_signed == 0) && (first < 0)))
   {
-    pfprintf(f, 2, "q = n;\n");
+    fprintf(stderr, "Error: %s\n", kdiv_strerror(KDIV_E_RANGE));
+    return (1);
   }
-  else if (d == -1)
+  
+  sprintf(kname, "%s.c", name);
+  sprintf(hname, "%s_selftest.c", name);
+  sprintf(soname, "./%s_selftest.so", name);
+  sprintf(sym, "%s_selftest", name);
+  kdiv_buf_init(&b, data, sizeof(data));
+  ret = kdiv_emit_selftest_ansic(&b, spec, kname);
+  if (ret != KDIV_OK)
   {
-    pfprintf(f, 2, "q = -n;\n");
+    fprintf(stderr, "Error: %s\n", kdiv_strerror(ret));
+    return (1);
   }
-  else if (ispowof2(d) == 1)
+  if (write_file(hname, &b) != 0)
   {
-    // shrsi t, n, k-1
-    pfprintf(f, 2, "t = n >> %d;\n", k-1);
-    // shri  t, t, W-k
-    pfprintf(f, 2, "u = t >> %d;\n", W-k);
-    // add   t, n, t
-    pfprintf(f, 2, "t = n + u;\n");
-    // shrsi q, t, k
-    pfprintf(f, 2, "q = t >> %d;\n", k);
-    // neg   q, q                // for negative divisors (d < 0)
-    if (d < 0)
-    {
-      pfprintf(f, 2, "q = -q;\n");
-    }
+    return (1);
   }
-  else
+  cmd = malloc(strlen(cc_cmd) + strlen(soname) + strlen(hname) + 64);
+  sprintf(cmd, "%s -shared -fPIC -fno-semantic-interposition -o %s %s", cc_cmd, soname, hname);
+  ret = system(cmd);
+  free(cmd);
+  if (ret != 0)
   {
-    // mulhs q, M, n
-    pfprintf(f, 2, "t = (signed long long int)M * (signed long long int)n;\n");
-    pfprintf(f, 2, "q = t >> %d;\n", W);   
-    // add|sub  q, q, n             // correction term for certain divisors
-    if ((d > 0) && (M < 0))
-    {
-      pfprintf(f, 2, "q = q + n;\n");
-    }    
-    else if ((d < 0) && (M > 0))
-    {
-      pfprintf(f, 2, "q = q - n;\n");
-    }
-    if (s > 0)
-    {
-      // shrsi q, q, s
-      pfprintf(f, 2, "q = q >> %d;\n", s);
-    }
-    // shri  t, n, W-1           // W is the word length
-    pfprintf(f, 2, "c = n >> %d;\n", W-1);
-    // add   q, q, t
-    pfprintf(f, 2, "q = q + c;\n");
-    // add   q, q, 1             // for negative divisors (d < 0) and (n != 0)
-    if (d < 0)
-    {
-      pfprintf(f, 2, "c = (n != 0);\n");
-      pfprintf(f, 2, "q = q + 1;\n");
-    }
+    fprintf(stderr, "Error: Cannot compile %s (kept for inspection).\n", hname);
+    return (1);
+  }
+  so = dlopen(soname, RTLD_NOW | RTLD_LOCAL);
+  if (so == NULL)
+  {
+    fprintf(stderr, "Error: %s\n", dlerror());
+    remove(hname);
+    remove(soname + 2);
+    return (1);
   }
-  pfprintf(f, 2, "return (q);\n");
-  pfprintf(f, 0, "}\n");
-}
-
-/* calculate_kdivs:
- * Perform a signed division by constant according to "Hacker's Delight" 
- * routines.
- */
-int calculate_kdivs(int M, int s, int n, int d, unsigned int W)
-{
-  signed long long int t, u;
-  int q;
-  int k;
-  unsigned int c;
   
-  k = log2ceil(ABS(d));
-  if (d == 1)
+  n = get_nthreads();
+  jobs = malloc(n * sizeof(struct selftest_job));
+  chunk = (last - first + n) / n;
+  // Shares of whole blocks, so that the routine runs on full blocks.
+  chunk = (chunk + SELFTEST_BLOCK - 1) / SELFTEST_BLOCK * SELFTEST_BLOCK;
+  for (i = 0; i < n; i++)
   {
-    q = n;
+    jobs[i].first = first + i*chunk;
+    jobs[i].last  = (jobs[i].first + chunk - 1 < last) ? 
+                     jobs[i].first + chunk - 1 : last;
+    // Converting the dlsym result through an object pointer is POSIX.
+    *(void **)(&jobs[i].fn) = dlsym(so, sym);
   }
-  else if (d == -1)
+  if (jobs[0].fn == NULL)
   {
-    q = -n;
+    fprintf(stderr, "Error: %s\n", dlerror());
+    free(jobs);
+    dlclose(so);
+    remove(hname);
+    remove(soname + 2);
+    return (1);
   }
-  else if (ispowof2(d) == 1)
+  selftest_divisor = spec->divisor;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  run_parallel(selftest_worker, jobs, sizeof(struct selftest_job), n);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  wall = elapsed_ns(&t0, &t1);
+  
+  for (i = 0; i < n; i++)
   {
-    // shrsi t, n, k-1
-    t = n >> (k-1);
-    // shri  t, t, W-k
-    u = t >> (W-k);
-    // add   t, n, t
-    t = n + u;
-    // shrsi q, t, k
-    q = t >> k;
-    // neg   q, q                // for negative divisors (d < 0)
-    if (d < 0)
+    for (j = 0; (enable_errors == 1) && (j < SELFTEST_NBAD) && 
+                ((unsigned long long int)j < jobs[i].bad); j++)
     {
-      q = -q;
+      if (is_signed == 0)
+      {
+        printf("Result NOT exact: %lld/%d = %u (%u)\n", jobs[i].badn[j], 
+          spec->divisor, jobs[i].badq[j], jobs[i].bade[j]);
+      }
+      else
+      {
+        printf("Result NOT exact: %lld/%d = %d (%d)\n", jobs[i].badn[j], 
+          spec->divisor, (int)jobs[i].badq[j], (int)jobs[i].bade[j]);
+      }
     }
+    bad   = bad + jobs[i].bad;
+    trout = trout + jobs[i].trout;
+    thw   = thw + jobs[i].thw;
   }
-  else
+  free(jobs);
+  dlclose(so);
+  remove(hname);
+  remove(soname + 2);
+  
+  total = (unsigned long long int)(last - first + 1);
+  printf("%s: %llu dividends checked, %llu mismatches\n", name, total, bad);
+  printf("%s: routine %.3f ns/div, hardware div %.3f ns/div", name, 
+    trout / total, thw / total);
+  if (trout > 0.0)
   {
-    // To use the results of this program, the compiler should generate the 
-    // li and mulhs instructions, generate the add if d > 0 and M < 0, or 
-    // the sub if d < 0 and M > 0, and generate the shrsi if s > 0. Then, 
-    // the shri and final add must be generated.  
-    // mulhs q, M, n
-    t = (signed long long int)M * (signed long long int)n;
-    q = t >> W;   
-    // add|sub  q, q, n             // correction term for certain divisors
-    if ((d > 0) && (M < 0))
-    {
-      q = q + n;
-    }    
-    else if ((d < 0) && (M > 0))
-    {
-      q = q - n;
-    }
-    // shrsi q, q, s
-    q = q >> s;
-    // shri  t, n, W-1           // W is the word length
-    c = n >> (W-1);
-    // add   q, q, t
-    q = q + c;
-    // add   q, q, 1             // for negative divisors (d < 0) and (n != 0)
-    if (d < 0)
-    {
-      c = (n != 0);
-      q = q + c;
-    }
+    printf(" (%.2fx)", thw / trout);
   }
-  return (q);
+  printf(", %.1f Mdiv/s checked on %d threads\n", 1e3 * total / wall, n);
+  return (bad != 0);
 }
 
 /* print_usage:
@@ -664,6 +1547,88 @@ static void print_usage()
   printf("*         Emit software routine in the NAC general assembly language (default).\n");
   printf("*   -ansic:\n");
   printf("*         Emit software routine in ANSI C (only for width=32).\n");
+  printf("*   -mulwidth <num>:\n");
+  printf("*         Set the width of the target multiplier. For widths below -width,\n");
+  printf("*         the high multiply is split into <num> x <num> -> 2*<num> partial\n");
+  printf("*         products, dropping low-order ones that cannot affect the quotient.\n");
+  printf("*         Must be at least 8 and divide -width. Default: same as -width.\n");
+  printf("*   -batch <num>:\n");
+  printf("*         Also emit <name>_x<num>.c with a routine dividing <num> values\n");
+  printf("*         (2, 4 or 8) at a time, interleaving the steps of the lanes for\n");
+  printf("*         instruction-level parallelism. Requires -ansic and width=32; with\n");
+  printf("*         -bench, emit a driver timing it against the single-value routine.\n");
+  printf("*   -selftest:\n");
+  printf("*         Compile the emitted routine with the C compiler of -cc into a\n");
+  printf("*         shared object, load it and compare it with hardware division for\n");
+  printf("*         all dividends (or those in [-lo, -hi]) in parallel, reporting\n");
+  printf("*         mismatches (listed with -errors) and the time per division of\n");
+  printf("*         both. Requires -ansic and width=32.\n");
+  printf("*   -cc <cmd>:\n");
+  printf("*         Set the compiler command for -selftest. Default:\n");
+  printf("*         \"cc -std=c99 -pedantic -Wall -Wextra -Werror -O3 -march=native\".\n");
+  printf("*   -stats:\n");
+  printf("*         Report the cost metrics of the emitted routine (add/fixup/shift\n");
+  printf("*         paths, operation count and critical-path depth).\n");
+  printf("*   -sweep:\n");
+  printf("*         Analyze the routines of all divisors in [-dlo, -dhi] in parallel\n");
+  printf("*         and print a histogram of their cost metrics. No routine is emitted.\n");
+  printf("*   -csv:\n");
+  printf("*         Print the sweep results as one CSV line per divisor.\n");
+  printf("*   -dlo <num>:\n");
+  printf("*         Set the lower divisor bound for -sweep. Default: 1.\n");
+  printf("*   -dhi <num>:\n");
+  printf("*         Set the higher divisor bound for -sweep. Default: 65535.\n");
+  printf("*   -prove:\n");
+  printf("*         Prove analytically that the routine of every divisor in [-dlo, -dhi]\n");
+  printf("*         (default: the whole divisor space of the width) is exact for all\n");
+  printf("*         dividends, and write a certificate file. Use -errors to list the\n");
+  printf("*         divisors that fail. No routine is emitted.\n");
+  printf("*   -cert <file>:\n");
+  printf("*         Set the certificate file for -prove. Default: kdiv_<u|s><W>_cert.txt.\n");
+  printf("*   -mod <num>:\n");
+  printf("*         Emit Barrett (and for odd moduli Montgomery) modular multiplication\n");
+  printf("*         kernels (mulmod/powmod, with array variants in ANSI C) for the given\n");
+  printf("*         constant modulus instead of a division routine. Operands are\n");
+  printf("*         unsigned and at most 32 bits wide. With -d, the reference\n");
+  printf("*         calculations are checked for dividends in [-lo, -hi].\n");
+  printf("*   -bench:\n");
+  printf("*         With -mod and -ansic, also emit a benchmark driver comparing the\n");
+  printf("*         kernels against the naive %% of the 64-bit product. With -bigdiv,\n");
+  printf("*         -batch or -dict, emit a driver comparing against hardware division.\n");
+  printf("*   -fp:\n");
+  printf("*         Emit ANSI C routines computing the quotient as a float or double\n");
+  printf("*         multiply by a rounded-up reciprocal (scalar, and an array routine\n");
+  printf("*         using AVX2/SSE2 where available), proven exact over the dividends\n");
+  printf("*         of the width or, if given, over [-lo, -hi]. With -stats, compare\n");
+  printf("*         the cost against the integer routine; with -bench (width=32),\n");
+  printf("*         emit a driver timing both forms.\n");
+  printf("*   -bigdiv <num>:\n");
+  printf("*         Emit ANSI C routines dividing multi-limb integers (arrays of 32-bit\n");
+  printf("*         limbs, least significant first) by the given constant, with a\n");
+  printf("*         precomputed reciprocal instead of hardware division. With -d, the\n");
+  printf("*         reference calculation is checked on exhaustive small and random\n");
+  printf("*         integers; with -bench, a throughput benchmark is also emitted.\n");
+  printf("*   -profile <file>:\n");
+  printf("*         Read a histogram of runtime divisors (\"divisor count\" per line)\n");
+  printf("*         and emit kdiv_<u|s><W>_dispatch.c, a routine that uses the\n");
+  printf("*         routines of the hot divisors and falls back to hardware division,\n");
+  printf("*         as a frequency-ordered chain or a switch, whichever has the lower\n");
+  printf("*         expected cost under the profile. Requires -ansic and width=32.\n");
+  printf("*   -dict <file>:\n");
+  printf("*         Read a dictionary of up to 256 divisors (one per line) and emit\n");
+  printf("*         kdiv_<u|s>32_dict.c, with routines dividing each element by the\n");
+  printf("*         divisor of its index, gathering the magic numbers per lane with\n");
+  printf("*         AVX-512/AVX2 where available. With -d, check them for the\n");
+  printf("*         dividends in [-lo, -hi] or, by default, for all of them; with\n");
+  printf("*         -bench, emit a driver timing them against hardware division.\n");
+  printf("*   -hot <num>:\n");
+  printf("*         Set the maximum number of hot divisors for -profile. Default: 12.\n");
+  printf("*   -divcost <num>:\n");
+  printf("*         Set the cost of a hardware division in the cost model of\n");
+  printf("*         -profile, in unit-latency operations. Default: 26.\n");
+  printf("*   -threads <num>:\n");
+  printf("*         Number of worker threads for parallel analyses. Default: number\n");
+  printf("*         of online processors.\n");
   printf("* \n");
   printf("* For further information, please refer to the website:\n");
   printf("* http://www.nkavvadias.com\n");
@@ -675,9 +1640,11 @@ int main(int argc, char *argv[])
 {
    struct mu magu;
    struct ms mags;
-   int i;
-   FILE *fout;
-   char *fout_name, suffix[4], ch='X';
+   struct kdiv_spec spec;
+   struct kdiv_buf name, code;
+   struct kdiv_mulw mulw;
+   char name_data[64], fout_name[72], code_data[4096], *heap=NULL;
+   int i, err;
 
    // If no arguments are passed, exit with help
    if (argc == 1)
@@ -749,6 +1716,7 @@ int main(int argc, char *argv[])
         {
           lo = atoi(argv[i]);
         }
+        has_nrange = 1;
       }
     }    
     else if (strcmp("-hi",argv[i]) == 0)
@@ -764,6 +1732,142 @@ int main(int argc, char *argv[])
         {
           hi = atoi(argv[i]);
         }
+        has_nrange = 1;
+      }
+    }    
+    else if (strcmp("-mulwidth",argv[i]) == 0)
+    {
+      if ((i+1) < argc)
+      {
+        i++;
+        mulwidth = atoi(argv[i]);
+      }
+    }    
+    else if (strcmp("-batch",argv[i]) == 0)
+    {
+      if ((i+1) < argc)
+      {
+        i++;
+        batch = atoi(argv[i]);
+      }
+    }    
+    else if (strcmp("-selftest", argv[i]) == 0)
+    {
+      enable_selftest = 1;
+    }
+    else if (strcmp("-cc",argv[i]) == 0)
+    {
+      if ((i+1) < argc)
+      {
+        i++;
+        cc_cmd = argv[i];
+      }
+    }    
+    else if (strcmp("-stats", argv[i]) == 0)
+    {
+      enable_stats = 1;
+    }
+    else if (strcmp("-sweep", argv[i]) == 0)
+    {
+      enable_sweep = 1;
+    }
+    else if (strcmp("-csv", argv[i]) == 0)
+    {
+      enable_csv = 1;
+    }
+    else if (strcmp("-bench", argv[i]) == 0)
+    {
+      enable_bench = 1;
+    }
+    else if (strcmp("-fp", argv[i]) == 0)
+    {
+      enable_fp = 1;
+    }
+    else if (strcmp("-mod",argv[i]) == 0)
+    {
+      if ((i+1) < argc)
+      {
+        i++;
+        modulus = parse_ll(argv[i]);
+      }
+    }
+    else if (strcmp("-bigdiv",argv[i]) == 0)
+    {
+      if ((i+1) < argc)
+      {
+        i++;
+        bigdiv = parse_ll(argv[i]);
+        has_bigdiv = 1;
+      }
+    }
+    else if (strcmp("-profile",argv[i]) == 0)
+    {
+      if ((i+1) < argc)
+      {
+        i++;
+        prof_name = argv[i];
+      }
+    }
+    else if (strcmp("-dict",argv[i]) == 0)
+    {
+      if ((i+1) < argc)
+      {
+        i++;
+        dict_name = argv[i];
+      }
+    }
+    else if (strcmp("-hot",argv[i]) == 0)
+    {
+      if ((i+1) < argc)
+      {
+        i++;
+        nhot = atoi(argv[i]);
+      }
+    }
+    else if (strcmp("-divcost",argv[i]) == 0)
+    {
+      if ((i+1) < argc)
+      {
+        i++;
+        divcost = atoi(argv[i]);
+      }
+    }
+    else if (strcmp("-prove", argv[i]) == 0)
+    {
+      enable_prove = 1;
+    }
+    else if (strcmp("-cert",argv[i]) == 0)
+    {
+      if ((i+1) < argc)
+      {
+        i++;
+        cert_name = argv[i];
+      }
+    }
+    else if (strcmp("-dlo",argv[i]) == 0)
+    {
+      if ((i+1) < argc)
+      {
+        i++;
+        dlo = parse_ll(argv[i]);
+        has_drange = 1;
+      }
+    }    
+    else if (strcmp("-dhi",argv[i]) == 0)
+    {
+      if ((i+1) < argc)
+      {
+        i++;
+        dhi = parse_ll(argv[i]);
+        has_drange = 1;
+      }
+    }    
+    else if (strcmp("-threads",argv[i]) == 0)
+    {
+      if ((i+1) < argc)
+      {
+        i++;
+        nthreads = atoi(argv[i]);
       }
     }    
     else
@@ -776,56 +1880,179 @@ int main(int argc, char *argv[])
     }
   }
   
-  if (divisor == 0)
+  if ((enable_sweep == 1) || (enable_prove == 1))
   {
-    fprintf(stderr, "Error: Requested division by zero.\n");
-    exit(1);
+    if ((width < 2) || (width > 32))
+    {
+      fprintf(stderr, "Error: %s\n", kdiv_strerror(KDIV_E_WIDTH));
+      exit(1);
+    }
   }
-  if ((is_signed == 0) && (divisor < 0))
+  if (enable_prove == 1)
   {
-    fprintf(stderr, "Error: Divisor must be positive for unsigned division.\n");
-    exit(1);
+    if (has_drange == 0)
+    {
+      dhi = (is_signed == 0) ? (long long)kdiv_ipowul(2, width) - 1 
+                             : (long long)kdiv_ipowul(2, width-1) - 1;
+      // -2^(W-1) is a divisor too, except for W = 32 (see kdiv_check).
+      dlo = (is_signed == 0) ? 1 : ((width < 32) ? -dhi - 1 : -dhi);
+    }
+    if (cert_name == NULL)
+    {
+      sprintf(name_data, "kdiv_%c%d_cert.txt", (is_signed == 0) ? 'u' : 's', 
+        width);
+      cert_name = name_data;
+    }
+    return (run_prove(cert_name));
+  }
+  if (enable_sweep == 1)
+  {
+    return (run_sweep());
+  }
+  if (modulus != 0)
+  {
+    if ((modulus < 0) || (modulus > 4294967295LL))
+    {
+      fprintf(stderr, "Error: %s\n", kdiv_strerror(KDIV_E_RANGE));
+      exit(1);
+    }
+    return (run_kmod((unsigned int)modulus));
+  }
+  if (has_bigdiv == 1)
+  {
+    if (bigdiv == 0)
+    {
+      fprintf(stderr, "Error: %s\n", kdiv_strerror(KDIV_E_DIVZERO));
+      exit(1);
+    }
+    if ((bigdiv < 0) || (bigdiv > 4294967295LL))
+    {
+      fprintf(stderr, "Error: %s\n", kdiv_strerror(KDIV_E_RANGE));
+      exit(1);
+    }
+    return (run_kbig((unsigned int)bigdiv));
+  }
+  if (prof_name != NULL)
+  {
+    // Like the ANSI C routines, the dispatch routine assumes 32-bit int.
+    if (width != 32)
+    {
+      fprintf(stderr, "Error: -profile supports only width=32.\n");
+      exit(1);
+    }
+    if ((enable_ansic == 0) || (nhot < 0))
+    {
+      fprintf(stderr, "Error: %s\n", kdiv_strerror(KDIV_E_UNSUPPORTED));
+      exit(1);
+    }
+    return (run_profile(prof_name));
+  }
+
+  if (dict_name != NULL)
+  {
+    // The per-lane routines use 32-bit vector lanes.
+    if (width != 32)
+    {
+      fprintf(stderr, "Error: -dict supports only width=32.\n");
+      exit(1);
+    }
+    return (run_dict(dict_name));
+  }
+
+  if (enable_fp == 1)
+  {
+    return (run_fp());
   }
 
-  fout_name = malloc(25 * sizeof(char));
-  if (enable_nac == 1)
+  spec.divisor   = divisor;
+  spec.width     = width;
+  spec.is_signed = is_signed;
+  spec.lang      = (enable_ansic == 1) ? KDIV_LANG_ANSIC : KDIV_LANG_NAC;
+  spec.mulwidth  = ((mulwidth > 0) && (mulwidth < width)) ? mulwidth : 0;
+
+  err = kdiv_check(divisor, width, is_signed);
+  if ((err == KDIV_OK) && (spec.mulwidth != 0))
+  {
+    err = (is_signed == 0) ? kdiv_mulw_u(&mulw, divisor, width, mulwidth)
+                           : kdiv_mulw_s(&mulw, divisor, width, mulwidth);
+  }
+  if ((err == KDIV_OK) && (batch != 0) && 
+      ((enable_ansic == 0) || (spec.mulwidth != 0) || (width != 32)))
+  {
+    err = KDIV_E_UNSUPPORTED;
+  }
+  if ((err == KDIV_OK) && (enable_selftest == 1) && 
+      ((enable_ansic == 0) || (width != 32)))
   {
-    strcpy(suffix, "nac");
+    err = KDIV_E_UNSUPPORTED;
   }
-  else if (enable_ansic == 1)
+  if (err != KDIV_OK)
   {
-    strcpy(suffix, "c");
+    fprintf(stderr, "Error: %s\n", kdiv_strerror(err));
+    exit(1);
   }
-  ch = (is_signed == 0) ? 'u' : 's';
 
-  sprintf(fout_name, "kdiv_%c%d_%c_%d.%s", ch, width, ((divisor > 0) ? 'p' : 'm'), ABS(divisor), suffix);
+  kdiv_buf_init(&name, name_data, sizeof(name_data));
+  kdiv_routine_name(&name, &spec);
+  sprintf(fout_name, "%s.%s", name_data, kdiv_lang_suffix(spec.lang));
+
+  kdiv_buf_init(&code, code_data, sizeof(code_data));
+  err = kdiv_generate(&code, &spec);
+  if (err == KDIV_E_NOSPACE)
+  {
+    heap = malloc(code.len + 1);
+    kdiv_buf_init(&code, heap, code.len + 1);
+    err = kdiv_generate(&code, &spec);
+  }
+  if (err != KDIV_OK)
+  {
+    fprintf(stderr, "Error: %s\n", kdiv_strerror(err));
+    free(heap);
+    exit(1);
+  }
+  if (write_file(fout_name, &code) != 0)
+  {
+    free(heap);
+    exit(1);
+  }
+  if ((batch != 0) && (run_batch(&spec, name_data) != 0))
+  {
+    free(heap);
+    exit(1);
+  }
+  if ((enable_selftest == 1) && (run_selftest(&spec, name_data) != 0))
+  {
+    free(heap);
+    exit(1);
+  }
 
   /* Calculate magic numbers for unsigned and signed division */
-  magu = magicu(divisor, width);
-  mags = magic(divisor, width);
-  
-  fout = fopen(fout_name, "w");
-  
   if (is_signed == 0)
   {
-    if (enable_nac == 1)
-    {
-      emit_kdivu_nac(fout, magu.M, magu.a, magu.s, divisor, width);
-    }
-    else if (enable_ansic == 1)
-    {
-      emit_kdivu_ansic(fout, magu.M, magu.a, magu.s, divisor, width);
-    }
+    magu = kdiv_magicu(divisor, width);
   }
   else
   {
-    if (enable_nac == 1)
+    mags = kdiv_magic(divisor, width);
+  }
+
+  if (enable_stats == 1)
+  {
+    struct kdiv_stats st;
+    if (is_signed == 0)
     {
-      emit_kdivs_nac(fout, mags.M, mags.s, divisor, width);
+      kdiv_stats_u(&st, divisor, width);
     }
-    else if (enable_ansic == 1)
+    else
+    {
+      kdiv_stats_s(&st, divisor, width);
+    }
+    print_stats(stdout, name_data, &st);
+    if (spec.mulwidth != 0)
     {
-      emit_kdivs_ansic(fout, mags.M, mags.s, divisor, width);
+      printf("%s: %d of %d partial products (%dx%d->%d), columns below %d dropped, carry-in %u\n",
+        name_data, mulw.nprod, (st.muls > 0) ? mulw.k * mulw.k : 0, mulwidth, 
+        mulwidth, 2*mulwidth, mulw.cd, mulw.cin);
     }
   }
 
@@ -837,13 +2064,25 @@ int main(int argc, char *argv[])
     {
       if (is_signed == 0)
       {
-        uquotapprox = calculate_kdivu(magu.M, magu.a, magu.s, i, divisor, width);
+        uquotapprox = kdiv_calculate_u(magu.M, magu.a, magu.s, i, divisor, width);
         uquotexact  = i/divisor;
+        if ((spec.mulwidth != 0) && 
+            (kdiv_calculate_u_mulw(&mulw, i) != uquotapprox))
+        {
+          printf("Split multiply NOT bit-exact: %d/%d = %u (%u)\n", 
+            i, divisor, kdiv_calculate_u_mulw(&mulw, i), uquotapprox);
+        }
       }
       else
       {
-        squotapprox = calculate_kdivs(mags.M, mags.s, i, divisor, width);
+        squotapprox = kdiv_calculate_s(mags.M, mags.s, i, divisor, width);
         squotexact  = i/divisor;
+        if ((spec.mulwidth != 0) && 
+            (kdiv_calculate_s_mulw(&mulw, i) != squotapprox))
+        {
+          printf("Split multiply NOT bit-exact: %d/%d = %d (%d)\n", 
+            i, divisor, kdiv_calculate_s_mulw(&mulw, i), squotapprox);
+        }
       }
 
       if ((is_signed == 0) && (uquotapprox != uquotexact))
@@ -881,16 +2120,15 @@ int main(int argc, char *argv[])
 #ifdef EMIT_TABLES
   for (i = 1; i < 32; i++)
   {
-    magu = magicu(i, width);
+    magu = kdiv_magicu(i, width);
     printf("%03d: M = %08x a = %d s = %d\n", i, magu.M, magu.a, magu.s);
   }
   for (i = 1; i < 32; i++)
   {
-    mags = magic(i, width);
+    mags = kdiv_magic(i, width);
     printf("%03d: M = %08x s = %d\n", i, mags.M, mags.s);
   }
 #endif   
-  free(fout_name);
-  fclose(fout);
+  free(heap);
   return 0;
 }
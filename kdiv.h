@@ -0,0 +1,309 @@
+/*
+ * File       : kdiv.h
+ * Description: Public interface of libkdiv, the generator and calculator for
+ *              division by integer constant routines. All entry points are
+ *              reentrant: they use no global state, never call exit() and
+ *              never perform file I/O; generated text is written into
+ *              caller-provided buffers.
+ * Author     : Nikolaos Kavvadias <nikolaos.kavvadias@gmail.com>
+ * Copyright  : (C) Nikolaos Kavvadias 2011-2021
+ * Website    : http://www.nkavvadias.com
+ *
+ * This file is part of kdiv, and is distributed under the terms of the
+ * Modified BSD License.
+ *
+ * A copy of the Modified BSD License is included with this distrubution
+ * in the files COPYING.BSD.
+ * kdiv is free software: you can redistribute it and/or modify it under the
+ * terms of the Modified BSD License.
+ * kdiv is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the Modified BSD License for more details.
+ *
+ * You should have received a copy of the Modified BSD License along with
+ * kdiv. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KDIV_H
+#define KDIV_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Status codes returned by the libkdiv API. */
+#define KDIV_OK               0
+#define KDIV_E_DIVZERO       -1   /* Requested division by zero. */
+#define KDIV_E_WIDTH         -2   /* Bitwidth outside [2, 32]. */
+#define KDIV_E_SIGN          -3   /* Negative divisor for unsigned division. */
+#define KDIV_E_RANGE         -4   /* Divisor not representable in width. */
+#define KDIV_E_UNSUPPORTED   -5   /* Unsupported constant division. */
+#define KDIV_E_NOSPACE       -6   /* Output buffer too small (truncated). */
+#define KDIV_E_ARG           -7   /* Invalid (e.g. NULL) argument. */
+#define KDIV_E_PROOF         -8   /* Correctness conditions do not hold. */
+#define KDIV_E_MULWIDTH      -9   /* Multiplier width unsupported for width. */
+
+/* Target languages for the emitted routines. */
+#define KDIV_LANG_NAC         0
+#define KDIV_LANG_ANSIC       1
+
+/* Fields of the w word of struct kdiv_lane. */
+#define KDIV_LANE_SHIFT    0x1FU  /* Post-multiply shift s. */
+#define KDIV_LANE_ADD      0x100U /* Add n to the high product. */
+#define KDIV_LANE_NEG      0x200U /* Signed: add -n instead of n. */
+#define KDIV_LANE_QSIGN    0x400U /* Signed: sign correction from q (d < 0). */
+#define KDIV_LANE_SIGN     0x800U /* Signed: apply the sign correction. */
+
+// ------------------------------ cut ----------------------------------
+struct mu {unsigned int M;     // Magic number,
+          int a;               // "add" indicator,
+          int s;};             // and shift amount.
+
+struct ms {int M;          // Magic number
+          int s;};         // and shift amount.
+// ---------------------------- end cut --------------------------------
+
+/*! Output buffer for the emitters. Text is appended at data[len]; when the
+ *  buffer fills up, output is truncated (and kept NUL-terminated) but len
+ *  keeps counting, so that after a failed call len + 1 is the size that
+ *  would have been required. data may be NULL with size 0 to only measure.
+ */
+struct kdiv_buf {
+  char   *data;
+  size_t  size;
+  size_t  len;
+};
+
+/*! Description of a single constant division routine.
+ */
+struct kdiv_spec {
+  int      divisor;            // Divisor (an integer except zero).
+  unsigned width;              // Bitwidth of dividend, divisor and quotient.
+  int      is_signed;          // 1 for signed, 0 for unsigned division.
+  int      lang;               // KDIV_LANG_NAC or KDIV_LANG_ANSIC.
+  unsigned mulwidth;           // Multiplier width; 0 (or >= width) for a 
+                               // full W x W -> 2W multiply.
+};
+
+/*! Cost metrics of a routine, counted in the operations of the pseudo-assembly
+ *  sequences that the emitters follow (li, mulhu/mulhs, add/sub, shifts, 
+ *  setne, neg). depth counts every operation as one cycle; lat weights the 
+ *  multiplies and conversions by KDIV_LAT_*. The constant load is counted in 
+ *  ops but is not on the critical path from n.
+ */
+struct kdiv_stats {
+  int pow2;                    // Power-of-2 divisor (no multiplication).
+  int add;                     // Unsigned "a == 1" add-and-carry path.
+  int fixup;                   // Signed add/sub correction of the product.
+  int shift;                   // Post-multiply shift by s > 0.
+  int muls;                    // Number of multiplications.
+  int ops;                     // Total number of operations.
+  int depth;                   // Critical-path depth from n to the quotient.
+  int lat;                     // Critical-path latency in cycles (KDIV_LAT_*).
+};
+
+/* Typical latencies, in cycles, of the operations that take more than one 
+   cycle on current cores; the other operations take one. */
+#define KDIV_LAT_MUL      3    // Integer (high) multiply.
+#define KDIV_LAT_CVT      4    // Conversion between integer and float/double.
+#define KDIV_LAT_FMUL     4    // Float/double multiply.
+
+/*! Certificate of the analytic correctness proof of the routine for one
+ *  divisor. With m the effective multiplier (M plus the 2^W term of the add
+ *  indicator or of the signed add/sub correction), p = W + s and 
+ *  e = m*|d| - 2^p, floor(m*n/2^p) equals floor(n/|d|) for all 
+ *  0 <= n <= nmax iff e >= 0, e*nc < 2^p and 
+ *  e*nmax + 2^p*(nmax mod |d|) < 2^p*|d|, where nc is the largest 
+ *  n <= nmax with n mod |d| = |d|-1 (Granlund-Montgomery). Dividends of the
+ *  opposite sign to the quotient are rounded up by the final sign 
+ *  correction and need the same bounds with <= and e > 0.
+ */
+struct kdiv_cert {
+  long long d;                 // Divisor.
+  unsigned int M;              // Magic number, as emitted (W bits).
+  int a;                       // "add" indicator or signed correction (+1/-1).
+  int s;                       // Post-multiply shift.
+  int p;                       // Total shift W + s.
+  unsigned long long m;        // Effective multiplier.
+  unsigned long long e;        // Error term m*|d| - 2^p.
+  unsigned long long nc[2];    // Critical dividends (nonnegative, negative).
+  int spot;                    // Failed reference evaluations at nc etc.
+  int ok;                      // 1 if the routine is proven exact.
+};
+
+/*! Decomposition of the W x W -> 2W high multiply of a routine into 
+ *  mw x mw -> 2mw partial products of the mw-bit limbs of M and n, with 
+ *  W = k*mw. The partial products in the columns below cd are dropped and 
+ *  the carry cin into column cd makes up for them (unsigned division only).
+ */
+struct kdiv_mulw {
+  long long d;                 // Divisor.
+  unsigned int W;              // Bitwidth.
+  unsigned int mw;             // Multiplier width.
+  int is_signed;               // 1 for signed, 0 for unsigned division.
+  unsigned int M;              // Magic number, as a W-bit pattern.
+  int a;                       // "add" indicator or signed correction (+1/-1).
+  int s;                       // Post-multiply shift.
+  int k;                       // Limbs per operand.
+  int cd;                      // First column that is computed.
+  unsigned int cin;            // Carry into column cd.
+  int nprod;                   // Partial products (0: no multiply needed).
+  unsigned int Ml[4];          // Limbs of M, least significant first.
+};
+
+/*! Constants of the modular multiplication kernels for a modulus m.
+ */
+struct kmod {
+  unsigned int m;              // Modulus.
+  unsigned long long int R;    // Barrett reciprocal floor(2^64/m).
+  unsigned int r1;             // 2^32 mod m (Montgomery form of 1).
+  unsigned int r2;             // 2^64 mod m (converts into Montgomery form).
+  unsigned int minv;           // -m^-1 mod 2^32 (Montgomery, odd m only).
+  int mont;                    // 1 if m is odd and Montgomery form applies.
+};
+
+/*! Divisor of a runtime-divisor profile and its number of calls.
+ */
+struct kdiv_prof {
+  int d;                       // Divisor.
+  unsigned long long int count; // Number of profiled calls.
+};
+
+/*! Expected cost per call of a profile-guided dispatch routine, in the 
+ *  unit-latency operations of struct kdiv_stats.
+ */
+struct kdiv_dcost {
+  double hit;                  // Fraction of calls to hot divisors.
+  double chain;                // Frequency-ordered comparison chain.
+  double table;                // Switch (balanced decision tree).
+  double div;                  // Hardware division only.
+  int use_table;               // 1 if the switch is cheaper than the chain.
+};
+
+/*! Constants of the division of multi-limb integers (32-bit limbs, least
+ *  significant first) by a single-limb constant, with a two-limb by 
+ *  one-limb reciprocal.
+ */
+struct kbig {
+  unsigned int d;              // Divisor.
+  int l;                       // Normalization shift (leading zeros of d).
+  unsigned int dn;             // Normalized divisor d << l.
+  unsigned int v;              // Reciprocal floor((2^64-1)/dn) - 2^32.
+};
+
+/*! Floating-point lowering of a division by constant: for |n| <= nmax, the
+ *  quotient is the truncation of fl(fl(n) * c), where c = mc * 2^-S is 1/|d|
+ *  rounded up to p = 24 (float) or p = 53 (double) significand bits and 
+ *  negated for d < 0.
+ */
+struct kdiv_fp {
+  long long d;                 // Divisor.
+  unsigned int W;              // Bitwidth.
+  int is_signed;               // 1 for signed, 0 for unsigned division.
+  int dbl;                     // 1 for double, 0 for float.
+  unsigned long long int mc;   // Significand of the reciprocal (p bits).
+  int S;                       // Scale of the reciprocal: |c| = mc * 2^-S.
+  unsigned long long int nmax; // Largest |n| of the proven dividend range.
+  int ok;                      // 1 if the lowering is proven exact.
+};
+
+/*! Parameters of a 32-bit division by one divisor of a dictionary, for 
+ *  routines whose divisor varies per element (lane): the magic number and 
+ *  the KDIV_LANE_* fields, applied by one branch-free sequence to all 
+ *  divisors, including powers of 2 and |d| = 1.
+ */
+struct kdiv_lane {
+  int d;                       // Divisor.
+  unsigned int M;              // Magic number (0 for unsigned powers of 2).
+  unsigned int w;              // Shift and KDIV_LANE_* flags.
+};
+
+/* Buffer handling and diagnostics. */
+void kdiv_buf_init(struct kdiv_buf *b, char *data, size_t size);
+int kdiv_bprintf(struct kdiv_buf *b, int nspaces, const char *fmt, ...);
+const char *kdiv_strerror(int err);
+
+/* Helpers. */
+unsigned long long int kdiv_ipowul(int base, int exponent);
+
+/* Validation of a divisor/width/signedness combination. */
+int kdiv_check(int d, unsigned W, int is_signed);
+
+/* Magic number calculation (arguments must pass kdiv_check). */
+struct mu kdiv_magicu(unsigned d, unsigned W);
+struct ms kdiv_magic(int d, unsigned W);
+
+/* Reference calculation of the division by constant. */
+unsigned int kdiv_calculate_u(unsigned int M, int a, int s, unsigned int n, unsigned int d, unsigned int W);
+int kdiv_calculate_s(int M, int s, int n, int d, unsigned int W);
+
+/* Cost metrics of the routines for a divisor. */
+int kdiv_stats_u(struct kdiv_stats *st, unsigned int d, unsigned int W);
+int kdiv_stats_s(struct kdiv_stats *st, int d, unsigned int W);
+
+/* Analytic proof of correctness over the whole dividend range. */
+int kdiv_prove_u(struct kdiv_cert *c, unsigned int d, unsigned int W);
+int kdiv_prove_s(struct kdiv_cert *c, int d, unsigned int W);
+int kdiv_cert_print(struct kdiv_buf *b, const struct kdiv_cert *c);
+
+/* Decomposition of the high multiply for narrow multipliers. */
+int kdiv_mulw_u(struct kdiv_mulw *w, unsigned int d, unsigned int W, unsigned int mw);
+int kdiv_mulw_s(struct kdiv_mulw *w, int d, unsigned int W, unsigned int mw);
+unsigned int kdiv_calculate_u_mulw(const struct kdiv_mulw *w, unsigned int n);
+int kdiv_calculate_s_mulw(const struct kdiv_mulw *w, int n);
+
+/* Barrett and Montgomery modular multiplication by a constant modulus. */
+int kdiv_kmod(struct kmod *k, unsigned int m, unsigned int W);
+unsigned int kdiv_calculate_mulmod_barrett(const struct kmod *k, unsigned int a, unsigned int b);
+unsigned int kdiv_calculate_powmod_barrett(const struct kmod *k, unsigned int b, unsigned int e);
+unsigned int kdiv_calculate_redc(const struct kmod *k, unsigned long long int T);
+unsigned int kdiv_calculate_powmod_mont(const struct kmod *k, unsigned int b, unsigned int e);
+int kdiv_emit_kmod_barrett_nac(struct kdiv_buf *f, const struct kmod *k, unsigned int W);
+int kdiv_emit_kmod_barrett_ansic(struct kdiv_buf *f, const struct kmod *k, unsigned int W);
+int kdiv_emit_kmod_mont_nac(struct kdiv_buf *f, const struct kmod *k, unsigned int W);
+int kdiv_emit_kmod_mont_ansic(struct kdiv_buf *f, const struct kmod *k, unsigned int W);
+int kdiv_emit_kmod_bench_ansic(struct kdiv_buf *f, const struct kmod *k, unsigned int W, const char *kname);
+
+/* Profile-guided dispatch for runtime divisors. */
+int kdiv_dispatch_cost(struct kdiv_dcost *c, const struct kdiv_prof *hot, int nhot, unsigned long long int cold, unsigned int W, int is_signed, int divcost);
+int kdiv_emit_dispatch_ansic(struct kdiv_buf *f, const struct kdiv_prof *hot, int nhot, unsigned int W, int is_signed, int table);
+
+/* Division of multi-limb integers by a single-limb constant. */
+int kdiv_kbig(struct kbig *k, unsigned int d);
+unsigned int kdiv_calculate_kbig_divrem(const struct kbig *k, unsigned int *q, const unsigned int *a, size_t n);
+int kdiv_emit_kbig_ansic(struct kdiv_buf *f, const struct kbig *k);
+int kdiv_emit_kbig_bench_ansic(struct kdiv_buf *f, const struct kbig *k, const char *kname);
+
+/* Floating-point reciprocal lowering. */
+int kdiv_fp(struct kdiv_fp *fp, int d, unsigned int W, int is_signed, unsigned long long int nmax);
+long long kdiv_calculate_fp(const struct kdiv_fp *fp, long long n);
+int kdiv_stats_fp(struct kdiv_stats *st, const struct kdiv_fp *fp);
+int kdiv_emit_fp_ansic(struct kdiv_buf *f, const struct kdiv_fp *fp);
+int kdiv_emit_fp_bench_ansic(struct kdiv_buf *f, const struct kdiv_fp *fp, const char *kname);
+
+/* Interleaved batch routines. */
+int kdiv_emit_batch_ansic(struct kdiv_buf *f, const struct kdiv_spec *spec, int N);
+int kdiv_emit_batch_bench_ansic(struct kdiv_buf *f, const struct kdiv_spec *spec);
+
+/* Self-test harness of the ANSI C routine (width 32). */
+int kdiv_emit_selftest_ansic(struct kdiv_buf *f, const struct kdiv_spec *spec, const char *kname);
+
+/* Per-lane divisors from a dictionary (width 32). */
+int kdiv_lane(struct kdiv_lane *l, int d, int is_signed);
+unsigned int kdiv_calculate_u_lane(const struct kdiv_lane *l, unsigned int n);
+int kdiv_calculate_s_lane(const struct kdiv_lane *l, int n);
+int kdiv_emit_dict_ansic(struct kdiv_buf *f, const struct kdiv_lane *l, int nl, int is_signed);
+int kdiv_emit_dict_bench_ansic(struct kdiv_buf *f, const struct kdiv_lane *l, int nl, int is_signed, const char *kname);
+
+/* One-shot interface: validate, compute magic numbers and emit. */
+int kdiv_routine_name(struct kdiv_buf *b, const struct kdiv_spec *spec);
+const char *kdiv_lang_suffix(int lang);
+int kdiv_generate(struct kdiv_buf *b, const struct kdiv_spec *spec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KDIV_H */
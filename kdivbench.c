@@ -0,0 +1,181 @@
+/*
+ * File       : kdivbench.c
+ * Description: Throughput benchmark for libkdiv: measures how many division
+ *              by constant routines are generated per second when many
+ *              threads use the library concurrently.
+ * Author     : Nikolaos Kavvadias <nikolaos.kavvadias@gmail.com>
+ * Copyright  : (C) Nikolaos Kavvadias 2011-2021
+ * Website    : http://www.nkavvadias.com
+ *
+ * This file is part of kdiv, and is distributed under the terms of the
+ * Modified BSD License.
+ *
+ * A copy of the Modified BSD License is included with this distrubution
+ * in the files COPYING.BSD.
+ * kdiv is free software: you can redistribute it and/or modify it under the
+ * terms of the Modified BSD License.
+ * kdiv is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the Modified BSD License for more details.
+ *
+ * You should have received a copy of the Modified BSD License along with
+ * kdiv. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include "kdiv.h"
+
+/* Per-thread benchmark state. */
+struct bench_job {
+  pthread_t     tid;
+  int           started;        // 1 if tid runs the job, 0 if run inline.
+  int           first;          // First divisor generated by this thread.
+  int           count;          // Number of routines to generate.
+  unsigned      width;
+  unsigned long bytes;          // Total generated text (for checking).
+  int           errors;
+};
+
+/*! Thread body: generate count routines cycling through unsigned/signed and
+ *  NAC/ANSI C variants for consecutive divisors.
+ */
+static void *bench_worker(void *arg)
+{
+  struct bench_job *job = arg;
+  struct kdiv_spec spec;
+  struct kdiv_buf b;
+  char data[1024];
+  int i, d, dmax;
+
+  dmax = (1 << (job->width - 1)) - 1;
+  for (i = 0; i < job->count; i++)
+  {
+    d = 1 + (job->first + i/4) % dmax;
+    spec.divisor   = ((i & 2) != 0 && (i & 4) != 0) ? -d : d;
+    spec.width     = job->width;
+    spec.is_signed = ((i & 2) != 0);
+    spec.lang      = ((i & 1) != 0) ? KDIV_LANG_ANSIC : KDIV_LANG_NAC;
+    spec.mulwidth  = 0;
+    kdiv_buf_init(&b, data, sizeof(data));
+    if (kdiv_generate(&b, &spec) != KDIV_OK)
+    {
+      job->errors++;
+    }
+    job->bytes += b.len;
+  }
+  return (NULL);
+}
+
+/*! Return a monotonic timestamp in seconds.
+ */
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (ts.tv_sec + ts.tv_nsec * 1e-9);
+}
+
+/* print_usage:
+ * Print usage instructions for the "kdivbench" program.
+ */
+static void print_usage()
+{
+  printf("\n");
+  printf("* Usage:\n");
+  printf("* ./kdivbench.exe [options]\n");
+  printf("* \n");
+  printf("* Options:\n");
+  printf("* \n");
+  printf("*   -h:\n");
+  printf("*         Print this help.\n");
+  printf("*   -threads <num>:\n");
+  printf("*         Number of concurrent generator threads. Default: 4.\n");
+  printf("*   -count <num>:\n");
+  printf("*         Number of routines generated per thread. Default: 100000.\n");
+  printf("*   -width <num>:\n");
+  printf("*         Set the bitwidth of the generated routines. Default: 32.\n");
+}
+
+/*! Program entry.
+ */
+int main(int argc, char *argv[])
+{
+  struct bench_job *jobs;
+  int nthreads=4, count=100000, i, errors=0;
+  unsigned width=32;
+  unsigned long bytes=0;
+  double t0, t1;
+
+  for (i = 1; i < argc; i++)
+  {
+    if (strcmp("-h", argv[i]) == 0)
+    {
+      print_usage();
+      exit(1);
+    }
+    else if ((strcmp("-threads", argv[i]) == 0) && ((i+1) < argc))
+    {
+      nthreads = atoi(argv[++i]);
+    }
+    else if ((strcmp("-count", argv[i]) == 0) && ((i+1) < argc))
+    {
+      count = atoi(argv[++i]);
+    }
+    else if ((strcmp("-width", argv[i]) == 0) && ((i+1) < argc))
+    {
+      width = atoi(argv[++i]);
+    }
+    else
+    {
+      print_usage();
+      exit(1);
+    }
+  }
+  if ((nthreads < 1) || (count < 1) || (kdiv_check(1, width, 1) != KDIV_OK))
+  {
+    fprintf(stderr, "Error: Invalid benchmark parameters.\n");
+    exit(1);
+  }
+
+  jobs = calloc(nthreads, sizeof(struct bench_job));
+  if (jobs == NULL)
+  {
+    fprintf(stderr, "Error: Out of memory.\n");
+    exit(1);
+  }
+  t0 = now();
+  for (i = 0; i < nthreads; i++)
+  {
+    jobs[i].first = i * count;
+    jobs[i].count = count;
+    jobs[i].width = width;
+    jobs[i].started = (pthread_create(&jobs[i].tid, NULL, bench_worker, 
+                        &jobs[i]) == 0);
+    if (jobs[i].started == 0)
+    {
+      // Out of threads: run the job in this one.
+      bench_worker(&jobs[i]);
+    }
+  }
+  for (i = 0; i < nthreads; i++)
+  {
+    if (jobs[i].started == 1)
+    {
+      pthread_join(jobs[i].tid, NULL);
+    }
+    bytes  += jobs[i].bytes;
+    errors += jobs[i].errors;
+  }
+  t1 = now();
+
+  printf("threads: %d, routines: %ld, bytes: %lu, errors: %d\n",
+    nthreads, (long)nthreads * count, bytes, errors);
+  printf("elapsed: %.3f s, %.0f routines/s\n",
+    t1 - t0, (double)nthreads * count / (t1 - t0));
+  free(jobs);
+  return ((errors == 0) ? 0 : 1);
+}
@@ -0,0 +1,1094 @@
+/*
+ * File       : kdivscan.c
+ * Description: Scanner for hardware divisions by constants in compiled x86
+ *              and x86-64 ELF objects and executables: disassembles them
+ *              with objdump, reports every div/idiv instruction per function
+ *              and emits the libkdiv routines of the constant divisors.
+ * Author     : Nikolaos Kavvadias <nikolaos.kavvadias@gmail.com>
+ * Copyright  : (C) Nikolaos Kavvadias 2011-2021
+ * Website    : http://www.nkavvadias.com
+ *
+ * This file is part of kdiv, and is distributed under the terms of the
+ * Modified BSD License.
+ *
+ * A copy of the Modified BSD License is included with this distrubution
+ * in the files COPYING.BSD.
+ * kdiv is free software: you can redistribute it and/or modify it under the
+ * terms of the Modified BSD License.
+ * kdiv is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the Modified BSD License for more details.
+ *
+ * You should have received a copy of the Modified BSD License along with
+ * kdiv. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "kdiv.h"
+
+/* Longest objdump line handled; longer ones are truncated. */
+#define LINE_MAX_LEN      1024
+/* Largest number of distinct routines emitted per run. */
+#define MAX_ROUTINES      1024
+
+/* Section of the scanned file (objdump -h). */
+struct section {
+  char name[64];
+  unsigned long long int size, vma, off;
+  int alloc;                   // Occupies memory at run time.
+  int ro;                      // Read-only data (not code).
+};
+
+/* Symbol of the scanned file (objdump -t). */
+struct symbol {
+  char name[128];
+  char sec[64];
+  unsigned long long int value;
+};
+
+/* Disassembled instruction. */
+struct insn {
+  unsigned long long int addr;
+  char mnem[16];
+  char ops[96];                // Operands (AT&T order), comment removed.
+  int has_ref;                 // Address in the "# addr <sym>" comment.
+  unsigned long long int ref;
+  int has_rel;                 // Relocation within the instruction.
+  unsigned long long int roff; // Its offset (the address it patches).
+  char rsym[128];              // Its symbol.
+  long long radd;              // Its addend.
+};
+
+/* Scanned file with its sections, symbols and the current function. */
+struct image {
+  const char *fname;
+  FILE *raw;
+  struct section *secs;
+  int nsecs;
+  struct symbol *syms;
+  int nsyms;
+  char func[256];
+  struct insn *ins;
+  int nins, cap;
+  unsigned long long int *tgts; // Sorted branch targets of the function.
+  int ntgts;
+  int indirect;                 // 1 if the function has an indirect jump.
+};
+
+/* Source of a divisor. */
+struct divsrc {
+  int known;                   // 1 if the divisor is a constant.
+  unsigned long long int val;  // Its value (zero-extended from its width).
+  char how[160];               // Description: immediate, section or reason.
+};
+
+/* Routine already emitted. */
+struct routine {
+  int d;
+  unsigned int W;
+  int is_signed;
+};
+
+const char *objdump_cmd="objdump";
+int enable_nac=1, enable_ansic=0, enable_emit=1;
+struct routine routines[MAX_ROUTINES];
+int nroutines=0;
+long total_divs=0, total_const=0;
+
+/* Register names by number (rax, rcx, ..., r15) and width. */
+static const char *regs64[16] = {"rax", "rcx", "rdx", "rbx", "rsp", "rbp",
+  "rsi", "rdi", "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15"};
+static const char *regs32[16] = {"eax", "ecx", "edx", "ebx", "esp", "ebp",
+  "esi", "edi", "r8d", "r9d", "r10d", "r11d", "r12d", "r13d", "r14d", "r15d"};
+static const char *regs16[16] = {"ax", "cx", "dx", "bx", "sp", "bp",
+  "si", "di", "r8w", "r9w", "r10w", "r11w", "r12w", "r13w", "r14w", "r15w"};
+static const char *regs8[16] = {"al", "cl", "dl", "bl", "spl", "bpl",
+  "sil", "dil", "r8b", "r9b", "r10b", "r11b", "r12b", "r13b", "r14b", "r15b"};
+
+
+/*! Return the number (0-15) of the register operand op ("%ecx") and store
+ *  its width in bits into *W, or return -1 if op is not a register.
+ */
+static int reg_parse(const char *op, unsigned int *W)
+{
+  int i;
+
+  if (op[0] != '%')
+  {
+    return (-1);
+  }
+  op++;
+  for (i = 0; i < 16; i++)
+  {
+    if (strcmp(op, regs64[i]) == 0)
+    {
+      *W = 64;
+      return (i);
+    }
+    if (strcmp(op, regs32[i]) == 0)
+    {
+      *W = 32;
+      return (i);
+    }
+    if (strcmp(op, regs16[i]) == 0)
+    {
+      *W = 16;
+      return (i);
+    }
+    if (strcmp(op, regs8[i]) == 0)
+    {
+      *W = 8;
+      return (i);
+    }
+  }
+  if ((op[1] == 'h') && (op[2] == '\0') && (strchr("acdb", op[0]) != NULL))
+  {
+    *W = 8;
+    return ((op[0] == 'a') ? 0 : (op[0] == 'c') ? 1 : (op[0] == 'd') ? 2 : 3);
+  }
+  return (-1);
+}
+
+/*! Split the operands of an AT&T instruction into its source (all but the
+ *  last operand) and destination (the last one), at the last comma outside
+ *  parentheses. With a single operand, src is empty.
+ */
+static void split_ops(const char *ops, char *src, char *dst, size_t size)
+{
+  int depth = 0, cut = -1, i;
+
+  for (i = 0; ops[i] != '\0'; i++)
+  {
+    if (ops[i] == '(')
+    {
+      depth++;
+    }
+    else if (ops[i] == ')')
+    {
+      depth--;
+    }
+    else if ((ops[i] == ',') && (depth == 0))
+    {
+      cut = i;
+    }
+  }
+  if (cut < 0)
+  {
+    src[0] = '\0';
+    strncpy(dst, ops, size - 1);
+    dst[size - 1] = '\0';
+    return;
+  }
+  if ((size_t)cut >= size)
+  {
+    cut = (int)size - 1;
+  }
+  memcpy(src, ops, cut);
+  src[cut] = '\0';
+  strncpy(dst, ops + cut + 1, size - 1);
+  dst[size - 1] = '\0';
+}
+
+/*! Return 1 if the mnemonic transfers control (ending a basic block).
+ */
+static int is_branch(const char *m)
+{
+  return ((m[0] == 'j') || (strncmp(m, "call", 4) == 0) ||
+          (strncmp(m, "ret", 3) == 0) || (strncmp(m, "loop", 4) == 0) ||
+          (strcmp(m, "ud2") == 0) || (strcmp(m, "hlt") == 0) ||
+          (strcmp(m, "syscall") == 0));
+}
+
+/*! Compare two addresses for qsort.
+ */
+static int cmp_addr(const void *a, const void *b)
+{
+  unsigned long long int x = *(const unsigned long long int *)a;
+  unsigned long long int y = *(const unsigned long long int *)b;
+  return ((x < y) ? -1 : (x > y) ? 1 : 0);
+}
+
+/*! Collect the sorted branch targets of the current function and note 
+ *  whether it has indirect jumps (e.g. through a switch table), whose 
+ *  targets are unknown.
+ */
+static void find_targets(struct image *im)
+{
+  char *end;
+  int i;
+
+  im->tgts = realloc(im->tgts, (im->nins + 1) * sizeof(unsigned long long int));
+  im->ntgts = 0;
+  im->indirect = 0;
+  for (i = 0; i < im->nins; i++)
+  {
+    if ((im->ins[i].mnem[0] == 'j') && (im->ins[i].ops[0] == '*'))
+    {
+      im->indirect = 1;
+    }
+    else if ((im->ins[i].mnem[0] == 'j') || (strncmp(im->ins[i].mnem, "loop", 4) == 0))
+    {
+      im->tgts[im->ntgts] = strtoull(im->ins[i].ops, &end, 16);
+      im->ntgts += (end != im->ins[i].ops);
+    }
+  }
+  qsort(im->tgts, im->ntgts, sizeof(unsigned long long int), cmp_addr);
+}
+
+/*! Return 1 if the instruction at addr is the target of a branch of the 
+ *  current function (the start of a basic block with more than one 
+ *  predecessor).
+ */
+static int is_target(const struct image *im, unsigned long long int addr)
+{
+  return (bsearch(&addr, im->tgts, im->ntgts, sizeof(unsigned long long int), 
+    cmp_addr) != NULL);
+}
+
+/*! Return 1 if a basic block may start at instruction in: at a branch 
+ *  target or, in a function with an indirect jump, anywhere. Backward 
+ *  traces stop after such an instruction, so in the latter case only the
+ *  instruction right before the division is trusted.
+ */
+static int may_start_block(const struct image *im, const struct insn *in)
+{
+  return ((im->indirect == 1) || (is_target(im, in->addr) == 1));
+}
+
+/*! Return 1 if instruction i writes register reg, either explicitly as its
+ *  destination operand or implicitly.
+ */
+static int writes_reg(const struct insn *in, int reg)
+{
+  const char *m = in->mnem;
+  char src[96], dst[96];
+  unsigned int W;
+
+  if ((strncmp(m, "cmp", 3) == 0) || (strncmp(m, "test", 4) == 0) ||
+      (strncmp(m, "bt", 2) == 0) || (strncmp(m, "push", 4) == 0) ||
+      (strncmp(m, "nop", 3) == 0) || (strncmp(m, "prefetch", 8) == 0))
+  {
+    return (0);
+  }
+  // Implicit destinations: rax/rdx (sign extension, one-operand multiply
+  // and divide, rdtsc, cpuid), rcx/rsi/rdi (string operations).
+  if ((strcmp(m, "cltd") == 0) || (strcmp(m, "cqto") == 0) ||
+      (strcmp(m, "cwtd") == 0))
+  {
+    return (reg == 2);
+  }
+  if ((strcmp(m, "cltq") == 0) || (strcmp(m, "cwtl") == 0) ||
+      (strcmp(m, "cbtw") == 0))
+  {
+    return (reg == 0);
+  }
+  if ((strncmp(m, "rdtsc", 5) == 0) || (strcmp(m, "cpuid") == 0))
+  {
+    return (reg <= 3);
+  }
+  split_ops(in->ops, src, dst, sizeof(dst));
+  if (((strncmp(m, "mul", 3) == 0) || (strncmp(m, "imul", 4) == 0) ||
+       (strncmp(m, "div", 3) == 0) || (strncmp(m, "idiv", 4) == 0)) &&
+      (src[0] == '\0'))
+  {
+    return ((reg == 0) || (reg == 2));
+  }
+  if ((strncmp(m, "rep", 3) == 0) || (strncmp(m, "stos", 4) == 0) ||
+      (strncmp(m, "movs", 4) == 0) || (strncmp(m, "lods", 4) == 0) ||
+      (strncmp(m, "scas", 4) == 0) || (strncmp(m, "cmps", 4) == 0))
+  {
+    if ((reg == 1) || (reg == 6) || (reg == 7) || (reg == 0))
+    {
+      return (1);
+    }
+  }
+  if ((strncmp(m, "xchg", 4) == 0) || (strncmp(m, "xadd", 4) == 0))
+  {
+    if (reg_parse(src, &W) == reg)
+    {
+      return (1);
+    }
+  }
+  return (reg_parse(dst, &W) == reg);
+}
+
+/*! Find the section containing the run-time address addr (linked files).
+ */
+static const struct section *find_section(const struct image *im,
+  unsigned long long int addr)
+{
+  int i;
+
+  for (i = 0; i < im->nsecs; i++)
+  {
+    if ((im->secs[i].alloc == 1) && (im->secs[i].vma <= addr) &&
+        (addr < im->secs[i].vma + im->secs[i].size))
+    {
+      return (&im->secs[i]);
+    }
+  }
+  return (NULL);
+}
+
+/*! Read the little-endian W-bit value at file offset off of the image.
+ */
+static int read_value(const struct image *im, unsigned long long int off,
+  unsigned int W, unsigned long long int *val)
+{
+  unsigned char b[8];
+  int i, n = W / 8;
+
+  if ((fseek(im->raw, (long)off, SEEK_SET) != 0) ||
+      (fread(b, 1, n, im->raw) != (size_t)n))
+  {
+    return (0);
+  }
+  *val = 0;
+  for (i = n - 1; i >= 0; i--)
+  {
+    *val = (*val << 8) | b[i];
+  }
+  return (1);
+}
+
+/*! Resolve the W-bit memory operand of instruction in, if it is a
+ *  RIP-relative reference to read-only data: through its relocation in
+ *  relocatable objects and through the address of the objdump comment in
+ *  linked files.
+ */
+static void resolve_mem(const struct image *im, const struct insn *in,
+  unsigned int W, struct divsrc *s)
+{
+  const struct section *sec = NULL;
+  unsigned long long int off = 0;
+  int i;
+
+  s->known = 0;
+  if ((in->has_rel == 0) && (strncmp(in->ops, "0x", 2) == 0) && 
+      (strchr(in->ops, '(') == NULL))
+  {
+    // Absolute address (linked 32-bit files).
+    sec = find_section(im, strtoull(in->ops, NULL, 16));
+    if (sec != NULL)
+    {
+      off = sec->off + (strtoull(in->ops, NULL, 16) - sec->vma);
+    }
+  }
+  else if (strstr(in->ops, "(%rip)") == NULL)
+  {
+    strcpy(s->how, "memory operand");
+    return;
+  }
+  else if (in->has_rel == 1)
+  {
+    for (i = 0; i < im->nsyms; i++)
+    {
+      if (strcmp(im->syms[i].name, in->rsym) == 0)
+      {
+        break;
+      }
+    }
+    if ((i == im->nsyms) || (strcmp(im->syms[i].sec, "*UND*") == 0))
+    {
+      // Constant only after linking: scan the linked file instead.
+      sprintf(s->how, "external symbol %.100s", in->rsym);
+      return;
+    }
+    for (sec = im->secs; sec < im->secs + im->nsecs; sec++)
+    {
+      if (strcmp(sec->name, im->syms[i].sec) == 0)
+      {
+        break;
+      }
+    }
+    if (sec == im->secs + im->nsecs)
+    {
+      sec = NULL;
+    }
+    else
+    {
+      // PC-relative: the operand is at S + A + (end of insn - relocation).
+      off = sec->off + (im->syms[i].value - sec->vma) + in->radd +
+        (in->ref - in->roff);
+    }
+  }
+  else if (in->has_ref == 1)
+  {
+    sec = find_section(im, in->ref);
+    if (sec != NULL)
+    {
+      off = sec->off + (in->ref - sec->vma);
+    }
+  }
+  if (sec == NULL)
+  {
+    strcpy(s->how, "unresolved address");
+    return;
+  }
+  if (sec->ro == 0)
+  {
+    sprintf(s->how, "writable %.60s", sec->name);
+    return;
+  }
+  if (read_value(im, off, W, &s->val) == 0)
+  {
+    sprintf(s->how, "unreadable %.60s", sec->name);
+    return;
+  }
+  s->known = 1;
+  sprintf(s->how, "%.60s", sec->name);
+}
+
+/*! Trace the value of register reg (used with width W) at instruction k
+ *  back through register copies to an immediate or a read-only load within
+ *  its basic block.
+ */
+static void trace_reg(const struct image *im, int k, int reg, unsigned int W,
+  struct divsrc *s)
+{
+  const struct insn *in;
+  char src[96], dst[96];
+  unsigned int Wd, Ws;
+  int j, sreg;
+
+  s->known = 0;
+  // A jump to the division itself starts its basic block there.
+  if (is_target(im, im->ins[k].addr) == 1)
+  {
+    strcpy(s->how, "defined in another basic block");
+    return;
+  }
+  for (j = k - 1; j >= 0; j--)
+  {
+    in = &im->ins[j];
+    if (is_branch(in->mnem) == 1)
+    {
+      strcpy(s->how, "defined in another basic block");
+      return;
+    }
+    if (writes_reg(in, reg) == 1)
+    {
+      split_ops(in->ops, src, dst, sizeof(dst));
+      // A 32-bit write zero-extends into the 64-bit register.
+      if ((strncmp(in->mnem, "mov", 3) != 0) ||
+          (strcmp(in->mnem, "movabs") != 0 && strlen(in->mnem) > 4) ||
+          (reg_parse(dst, &Wd) != reg) || ((Wd < W) && !(Wd == 32 && W == 64)))
+      {
+        sprintf(s->how, "computed by %.16s", in->mnem);
+        return;
+      }
+      if (src[0] == '$')
+      {
+        s->known = 1;
+        s->val = strtoull(src + 1, NULL, 16);
+        strcpy(s->how, "immediate");
+        return;
+      }
+      sreg = reg_parse(src, &Ws);
+      if ((sreg < 0) && (src[0] == '%'))
+      {
+        sprintf(s->how, "computed by %.16s", in->mnem);
+        return;
+      }
+      if (sreg >= 0)
+      {
+        if (Ws < Wd)
+        {
+          sprintf(s->how, "computed by %.16s", in->mnem);
+          return;
+        }
+        reg = sreg;
+        W = Wd;
+        if (may_start_block(im, in) == 1)
+        {
+          strcpy(s->how, "defined in another basic block");
+          return;
+        }
+        continue;
+      }
+      resolve_mem(im, in, Wd, s);
+      return;
+    }
+    if (may_start_block(im, in) == 1)
+    {
+      strcpy(s->how, "defined in another basic block");
+      return;
+    }
+  }
+  strcpy(s->how, "live on function entry");
+}
+
+/*! Return 1 if the high half of the dividend of the division at k is the
+ *  zero (unsigned) or sign (signed) extension of the low half, so that the
+ *  division is a W-bit one.
+ */
+static int narrow_dividend(const struct image *im, int k, int is_signed)
+{
+  const struct insn *in;
+  char src[96], dst[96];
+  unsigned int W;
+  int j;
+
+  if (is_target(im, im->ins[k].addr) == 1)
+  {
+    return (0);
+  }
+  for (j = k - 1; j >= 0; j--)
+  {
+    in = &im->ins[j];
+    if (is_branch(in->mnem) == 1)
+    {
+      return (0);
+    }
+    if (writes_reg(in, 2) == 1)
+    {
+      if (is_signed == 1)
+      {
+        return ((strcmp(in->mnem, "cltd") == 0) || (strcmp(in->mnem, "cqto") == 0) ||
+                (strcmp(in->mnem, "cwtd") == 0));
+      }
+      split_ops(in->ops, src, dst, sizeof(dst));
+      if (strncmp(in->mnem, "xor", 3) == 0)
+      {
+        return (reg_parse(src, &W) == 2);
+      }
+      return ((strncmp(in->mnem, "mov", 3) == 0) && (strcmp(src, "$0x0") == 0));
+    }
+    if (may_start_block(im, in) == 1)
+    {
+      return (0);
+    }
+  }
+  return (0);
+}
+
+/*! Write the routine for the divisor d unless it was already emitted, and
+ *  store its file name into fname.
+ */
+static int emit_routine(int d, unsigned int W, int is_signed, char *fname)
+{
+  struct kdiv_spec spec;
+  struct kdiv_buf name, code;
+  char name_data[64], code_data[4096];
+  FILE *fout;
+  int i, err;
+
+  spec.divisor   = d;
+  spec.width     = W;
+  spec.is_signed = is_signed;
+  spec.lang      = (enable_ansic == 1) ? KDIV_LANG_ANSIC : KDIV_LANG_NAC;
+  spec.mulwidth  = 0;
+  kdiv_buf_init(&name, name_data, sizeof(name_data));
+  kdiv_routine_name(&name, &spec);
+  sprintf(fname, "%s.%s", name_data, kdiv_lang_suffix(spec.lang));
+  for (i = 0; i < nroutines; i++)
+  {
+    if ((routines[i].d == d) && (routines[i].W == W) &&
+        (routines[i].is_signed == is_signed))
+    {
+      return (KDIV_OK);
+    }
+  }
+  kdiv_buf_init(&code, code_data, sizeof(code_data));
+  err = kdiv_generate(&code, &spec);
+  if (err != KDIV_OK)
+  {
+    return (err);
+  }
+  if (enable_emit == 1)
+  {
+    fout = fopen(fname, "w");
+    if (fout == NULL)
+    {
+      fprintf(stderr, "Error: Cannot open file %s for writing.\n", fname);
+      return (KDIV_E_ARG);
+    }
+    fwrite(code.data, 1, code.len, fout);
+    fclose(fout);
+  }
+  if (nroutines < MAX_ROUTINES)
+  {
+    routines[nroutines].d = d;
+    routines[nroutines].W = W;
+    routines[nroutines].is_signed = is_signed;
+    nroutines++;
+  }
+  return (KDIV_OK);
+}
+
+/*! Report the divisions of the current function and emit the routines of
+ *  those by constants.
+ */
+static void scan_function(struct image *im)
+{
+  struct divsrc s;
+  const struct insn *in;
+  char fname[96], note[160];
+  unsigned long long int mask;
+  unsigned int W;
+  char src[96], dst[96];
+  long long d;
+  int k, reg, is_signed, err, header=0;
+
+  find_targets(im);
+  for (k = 0; k < im->nins; k++)
+  {
+    in = &im->ins[k];
+    is_signed = (strncmp(in->mnem, "idiv", 4) == 0);
+    if ((is_signed == 0) && (strncmp(in->mnem, "div", 3) != 0))
+    {
+      continue;
+    }
+    // divss/divsd/divps/... are floating-point divisions; integer ones 
+    // have a single operand, which may contain commas (base, index).
+    split_ops(in->ops, src, dst, sizeof(dst));
+    if ((strlen(in->mnem) > (size_t)(4 + is_signed)) ||
+        ((strlen(in->mnem) == (size_t)(4 + is_signed)) &&
+         (strchr("bwlq", in->mnem[3 + is_signed]) == NULL)) ||
+        (src[0] != '\0'))
+    {
+      continue;
+    }
+    reg = reg_parse(in->ops, &W);
+    if (reg >= 0)
+    {
+      trace_reg(im, k, reg, W, &s);
+    }
+    else
+    {
+      switch (in->mnem[3 + is_signed])
+      {
+        case 'b': W = 8; break;
+        case 'w': W = 16; break;
+        case 'q': W = 64; break;
+        default:  W = 32; break;
+      }
+      resolve_mem(im, in, W, &s);
+    }
+    total_divs++;
+    if (header == 0)
+    {
+      printf("  %s:\n", im->func);
+      header = 1;
+    }
+    if (s.known == 0)
+    {
+      printf("    %8llx: %-6s %-24s %c%-2u  runtime divisor (%s)\n", in->addr,
+        in->mnem, in->ops, (is_signed == 0) ? 'u' : 's', W, s.how);
+      continue;
+    }
+    total_const++;
+    mask = (W == 64) ? ~0ULL : (1ULL << W) - 1;
+    d = (long long)(s.val & mask);
+    if ((is_signed == 1) && (W < 64) && (((unsigned long long)d >> (W - 1)) != 0))
+    {
+      d = d - (long long)(1ULL << W);
+    }
+    else if ((is_signed == 1) && (W == 64))
+    {
+      d = (long long)s.val;
+    }
+    if (W > 32)
+    {
+      strcpy(note, "no routine (width > 32)");
+    }
+    else if (W == 8)
+    {
+      strcpy(note, "no routine (16-by-8-bit division)");
+    }
+    else if (narrow_dividend(im, k, is_signed) == 0)
+    {
+      sprintf(note, "no routine (%u-bit dividend)", 2 * W);
+    }
+    else if ((d > 2147483647LL) || (d < -2147483647LL))
+    {
+      strcpy(note, "no routine (divisor beyond int)");
+    }
+    else
+    {
+      err = emit_routine((int)d, W, is_signed, fname);
+      if (err == KDIV_OK)
+      {
+        sprintf(note, "-> %s", fname);
+      }
+      else
+      {
+        sprintf(note, "no routine (%s)", kdiv_strerror(err));
+      }
+    }
+    printf("    %8llx: %-6s %-24s %c%-2u  d = %lld (%s) %s\n", in->addr,
+      in->mnem, in->ops, (is_signed == 0) ? 'u' : 's', W, d, s.how, note);
+  }
+}
+
+/*! Run objdump with the given options on the image and return its output.
+ */
+static FILE *run_objdump(const struct image *im, const char *opts)
+{
+  char cmd[LINE_MAX_LEN + 64];
+  size_t i, n;
+
+  // Quote the file name for the shell.
+  n = (size_t)sprintf(cmd, "%s %s '", objdump_cmd, opts);
+  for (i = 0; (im->fname[i] != '\0') && (n < LINE_MAX_LEN); i++)
+  {
+    if (im->fname[i] == '\'')
+    {
+      strcpy(cmd + n, "'\\''");
+      n += 4;
+    }
+    else
+    {
+      cmd[n++] = im->fname[i];
+    }
+  }
+  strcpy(cmd + n, "'");
+  fflush(stdout);
+  return (popen(cmd, "r"));
+}
+
+/*! Read the section headers of the image (objdump -h).
+ */
+static int load_sections(struct image *im)
+{
+  struct section sec;
+  char line[LINE_MAX_LEN];
+  FILE *p;
+  int idx;
+
+  p = run_objdump(im, "-h -w");
+  if (p == NULL)
+  {
+    return (1);
+  }
+  while (fgets(line, sizeof(line), p) != NULL)
+  {
+    if (sscanf(line, "%d %63s %llx %llx %*x %llx", &idx, sec.name, &sec.size,
+          &sec.vma, &sec.off) != 5)
+    {
+      continue;
+    }
+    sec.alloc = (strstr(line, "ALLOC") != NULL);
+    sec.ro    = (strstr(line, "READONLY") != NULL) &&
+                (strstr(line, "CODE") == NULL) && (strstr(line, "CONTENTS") != NULL);
+    im->secs = realloc(im->secs, (im->nsecs + 1) * sizeof(struct section));
+    im->secs[im->nsecs++] = sec;
+  }
+  return ((pclose(p) != 0) || (im->nsecs == 0));
+}
+
+/*! Read the symbol table of the image (objdump -t), used to resolve the
+ *  relocations of relocatable objects.
+ */
+static int load_symbols(struct image *im)
+{
+  struct symbol sym;
+  char line[LINE_MAX_LEN], *tab, *name;
+  size_t h;
+  FILE *p;
+
+  p = run_objdump(im, "-t -w");
+  if (p == NULL)
+  {
+    return (1);
+  }
+  while (fgets(line, sizeof(line), p) != NULL)
+  {
+    // <value> <7 flag characters> <section>\t<size> <name>
+    line[strcspn(line, "\n")] = '\0';
+    tab = strchr(line, '\t');
+    h = strspn(line, "0123456789abcdef");
+    if ((tab == NULL) || (h < 8) || (line[h] != ' ') || (tab < line + h + 9))
+    {
+      continue;
+    }
+    sym.value = strtoull(line, NULL, 16);
+    *tab = '\0';
+    if (sscanf(line + h + 9, "%63s", sym.sec) != 1)
+    {
+      continue;
+    }
+    name = strrchr(tab + 1, ' ');
+    name = (name != NULL) ? name + 1 : tab + 1;
+    strncpy(sym.name, name, sizeof(sym.name) - 1);
+    sym.name[sizeof(sym.name) - 1] = '\0';
+    im->syms = realloc(im->syms, (im->nsyms + 1) * sizeof(struct symbol));
+    im->syms[im->nsyms++] = sym;
+  }
+  return (pclose(p) != 0);
+}
+
+/*! Parse a relocation "<offset>: <type>\t<symbol>[+-]<addend>" into in
+ *  (PC-relative 32-bit relocations only).
+ */
+static void parse_reloc(struct insn *in, char *rel)
+{
+  char *sym, *add;
+
+  if ((strstr(rel, "R_X86_64_PC32") == NULL) || ((sym = strchr(rel, '\t')) == NULL))
+  {
+    return;
+  }
+  in->roff = strtoull(rel, NULL, 16);
+  sym++;
+  sym[strcspn(sym, "\n")] = '\0';
+  in->radd = 0;
+  add = strstr(sym, "+0x");
+  add = (add == NULL) ? strstr(sym, "-0x") : add;
+  if (add != NULL)
+  {
+    in->radd = strtoll(add + 1, NULL, 16);
+    in->radd = (add[0] == '-') ? -in->radd : in->radd;
+    *add = '\0';
+  }
+  strncpy(in->rsym, sym, sizeof(in->rsym) - 1);
+  in->rsym[sizeof(in->rsym) - 1] = '\0';
+  in->has_rel = 1;
+}
+
+/*! Parse an instruction line "<addr>:\t<mnemonic> <operands> [# <ref>]
+ *  [\t<relocation>]" of objdump -d -r -w into in. Returns 0 for other lines.
+ */
+static int parse_insn(struct insn *in, char *line)
+{
+  char *p, *body, *rel, *cmt;
+  static const char *prefixes[] = {"rep", "repz", "repnz", "repe", "repne",
+    "lock", "notrack", "bnd", "data16", "addr32", "cs", "ds", "es", "ss",
+    "fs", "gs", NULL};
+  int i;
+
+  memset(in, 0, sizeof(*in));
+  p = line;
+  while (*p == ' ')
+  {
+    p++;
+  }
+  in->addr = strtoull(p, &body, 16);
+  if ((body == p) || (body[0] != ':') || (body[1] != '\t'))
+  {
+    return (0);
+  }
+  body += 2;
+  body[strcspn(body, "\n")] = '\0';
+  rel = strstr(body, ": R_");
+  if (rel != NULL)
+  {
+    while ((rel > body) && (rel[-1] != '\t'))
+    {
+      rel--;
+    }
+    if (rel > body)
+    {
+      rel[-1] = '\0';
+      parse_reloc(in, rel);
+    }
+  }
+  for (p = body; *p != '\0'; p++)
+  {
+    *p = (*p == '\t') ? ' ' : *p;
+  }
+  cmt = strstr(body, "# ");
+  if (cmt != NULL)
+  {
+    *cmt = '\0';
+    in->ref = strtoull(cmt + 2, &p, 16);
+    in->has_ref = (p != cmt + 2);
+  }
+  // Mnemonic (after any prefixes) and operands.
+  for (;;)
+  {
+    while (*body == ' ')
+    {
+      body++;
+    }
+    i = (int)strcspn(body, " ");
+    if (i >= (int)sizeof(in->mnem))
+    {
+      i = (int)sizeof(in->mnem) - 1;
+    }
+    memcpy(in->mnem, body, i);
+    in->mnem[i] = '\0';
+    body += i;
+    for (i = 0; prefixes[i] != NULL; i++)
+    {
+      if (strcmp(in->mnem, prefixes[i]) == 0)
+      {
+        break;
+      }
+    }
+    if ((prefixes[i] == NULL) || (*body == '\0'))
+    {
+      break;
+    }
+  }
+  while (*body == ' ')
+  {
+    body++;
+  }
+  i = (int)strlen(body);
+  while ((i > 0) && (body[i-1] == ' '))
+  {
+    body[--i] = '\0';
+  }
+  strncpy(in->ops, body, sizeof(in->ops) - 1);
+  return (1);
+}
+
+/*! Scan one ELF file: disassemble it function by function and report the
+ *  divisions of each.
+ */
+static int scan_file(const char *fname)
+{
+  struct image im;
+  char line[LINE_MAX_LEN], *p;
+  long divs=total_divs, consts=total_const;
+  FILE *dis;
+  int status;
+
+  memset(&im, 0, sizeof(im));
+  im.fname = fname;
+  im.raw = fopen(fname, "rb");
+  if (im.raw == NULL)
+  {
+    fprintf(stderr, "Error: Cannot open file %s for reading.\n", fname);
+    return (1);
+  }
+  if ((load_sections(&im) != 0) || (load_symbols(&im) != 0) ||
+      ((dis = run_objdump(&im, "-d -r -w --no-show-raw-insn")) == NULL))
+  {
+    fprintf(stderr, "Error: Cannot disassemble %s with %s.\n", fname, objdump_cmd);
+    fclose(im.raw);
+    free(im.secs);
+    free(im.syms);
+    return (1);
+  }
+  printf("%s:\n", fname);
+  while (fgets(line, sizeof(line), dis) != NULL)
+  {
+    // "<addr> <function>:" starts a function.
+    p = strstr(line, " <");
+    if ((isxdigit((unsigned char)line[0]) != 0) && (p != NULL) &&
+        (strstr(p, ">:") != NULL))
+    {
+      scan_function(&im);
+      im.nins = 0;
+      *strstr(p, ">:") = '\0';
+      strncpy(im.func, p + 2, sizeof(im.func) - 1);
+      continue;
+    }
+    if (im.nins == im.cap)
+    {
+      im.cap = (im.cap == 0) ? 256 : 2 * im.cap;
+      im.ins = realloc(im.ins, im.cap * sizeof(struct insn));
+    }
+    if (parse_insn(&im.ins[im.nins], line) == 1)
+    {
+      im.nins++;
+    }
+    else if ((im.nins > 0) && (strstr(line, ": R_") != NULL))
+    {
+      // Relocation on a line of its own (objdump without -w).
+      p = line + strspn(line, " \t");
+      parse_reloc(&im.ins[im.nins - 1], p);
+    }
+  }
+  scan_function(&im);
+  status = pclose(dis);
+  printf("%s: %ld divisions, %ld by constants\n", fname, total_divs - divs,
+    total_const - consts);
+  fclose(im.raw);
+  free(im.secs);
+  free(im.syms);
+  free(im.ins);
+  free(im.tgts);
+  return (status != 0);
+}
+
+/* print_usage:
+ * Print usage instructions for the "kdivscan" program.
+ */
+static void print_usage()
+{
+  printf("\n");
+  printf("* Usage:\n");
+  printf("* ./kdivscan.exe [options] <file> ...\n");
+  printf("* \n");
+  printf("* Report the div/idiv instructions of x86 and x86-64 ELF objects and\n");
+  printf("* executables per function and emit the routines of those whose divisor\n");
+  printf("* is an immediate or a read-only constant.\n");
+  printf("* \n");
+  printf("* Options:\n");
+  printf("* \n");
+  printf("*   -h:\n");
+  printf("*         Print this help.\n");
+  printf("*   -nac:\n");
+  printf("*         Emit the routines in the NAC general assembly language (default).\n");
+  printf("*   -ansic:\n");
+  printf("*         Emit the routines in ANSI C.\n");
+  printf("*   -noemit:\n");
+  printf("*         Only report the divisions; emit no routines.\n");
+  printf("*   -objdump <cmd>:\n");
+  printf("*         Set the objdump command. Default: objdump.\n");
+}
+
+/*! Program entry.
+ */
+int main(int argc, char *argv[])
+{
+  int i, nfiles=0, errors=0;
+
+  for (i = 1; i < argc; i++)
+  {
+    if (strcmp("-h", argv[i]) == 0)
+    {
+      print_usage();
+      exit(1);
+    }
+    else if (strcmp("-nac", argv[i]) == 0)
+    {
+      enable_nac   = 1;
+      enable_ansic = 0;
+    }
+    else if (strcmp("-ansic", argv[i]) == 0)
+    {
+      enable_nac   = 0;
+      enable_ansic = 1;
+    }
+    else if (strcmp("-noemit", argv[i]) == 0)
+    {
+      enable_emit = 0;
+    }
+    else if ((strcmp("-objdump", argv[i]) == 0) && ((i+1) < argc))
+    {
+      objdump_cmd = argv[++i];
+    }
+    else if (argv[i][0] == '-')
+    {
+      print_usage();
+      exit(1);
+    }
+  }
+  for (i = 1; i < argc; i++)
+  {
+    if (strcmp("-objdump", argv[i]) == 0)
+    {
+      i++;
+    }
+    else if (argv[i][0] != '-')
+    {
+      errors += scan_file(argv[i]);
+      nfiles++;
+    }
+  }
+  if (nfiles == 0)
+  {
+    print_usage();
+    exit(1);
+  }
+  printf("total: %ld divisions, %ld by constants, %d routines %s\n",
+    total_divs, total_const, nroutines, (enable_emit == 1) ? "emitted" : "found");
+  return ((errors == 0) ? 0 : 1);
+}
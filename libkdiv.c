@@ -0,0 +1,4011 @@
+/*
+ * File       : libkdiv.c
+ * Description: Generator and calculator for division by integer constant 
+ *              routines (libkdiv). Routines "kdiv_magic" and "kdiv_magicu" 
+ *              have been copied from Herny S. Warren's "Hacker's Delight". 
+ * Author     : Nikolaos Kavvadias <nikolaos.kavvadias@gmail.com>                
+ * Copyright  : (C) Nikolaos Kavvadias 2011-2021
+ * Website    : http://www.nkavvadias.com                            
+ *
+ * This file is part of kdiv, and is distributed under the terms of the  
+ * Modified BSD License.
+ *
+ * A copy of the Modified BSD License is included with this distrubution 
+ * in the files COPYING.BSD.
+ * kdiv is free software: you can redistribute it and/or modify it under the
+ * terms of the Modified BSD License. 
+ * kdiv is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the Modified BSD License for more details.
+ *
+ * You should have received a copy of the Modified BSD License along with 
+ * kdiv. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "kdiv.h"
+
+/* Absolute value of an integer. */
+#define ABS(x)            ((x) >  0 ? (x) : (-x))
+
+/*! Initialize an output buffer on top of caller-provided storage.
+ */
+void kdiv_buf_init(struct kdiv_buf *b, char *data, size_t size)
+{
+  b->data = data;
+  b->size = (data != NULL) ? size : 0;
+  b->len  = 0;
+  if (b->size > 0)
+  {
+    b->data[0] = '\0';
+  }
+}
+
+/*! Return the status of an output buffer: KDIV_OK if everything appended so 
+ *  far (plus the terminating NUL) fits, KDIV_E_NOSPACE otherwise.
+ */
+static int kdiv_buf_status(const struct kdiv_buf *b)
+{
+  return ((b->len < b->size) ? KDIV_OK : KDIV_E_NOSPACE);
+}
+
+/*! Append formatted text to an output buffer; vprintf counterpart of 
+ *  kdiv_bprintf.
+ */
+static void kdiv_vbprintf(struct kdiv_buf *b, const char *fmt, va_list args)
+{
+  size_t avail;
+  int n;
+  
+  avail = (b->len < b->size) ? b->size - b->len : 0;
+  n = vsnprintf((avail > 0) ? b->data + b->len : NULL, avail, fmt, args);
+  // vsnprintf leaves a truncated buffer NUL-terminated; a buffer that was
+  // already full keeps its earlier terminator.
+  if (n > 0)
+  {
+    b->len += (size_t)n;
+  }
+}
+
+/*! printf into an output buffer, prefixed by a number of space characters.
+ */
+int kdiv_bprintf(struct kdiv_buf *b, int nspaces, const char *fmt, ...)
+{
+  va_list args;
+  int i;
+  
+  for (i = 0; i < nspaces; i++)
+  {
+    if (b->len + 1 < b->size)
+    {
+      b->data[b->len]   = ' ';
+      b->data[b->len+1] = '\0';
+    }
+    b->len++;
+  }
+  va_start(args, fmt);
+  kdiv_vbprintf(b, fmt, args);
+  va_end(args);
+  return (kdiv_buf_status(b));
+}
+
+/*! Function to identify if the given unsigned integer is a power-of-2.
+ */
+static int ispowof2(unsigned int v)
+{
+  int f;
+  f = v && !(v & (v-1));
+  return (f);
+}
+
+/*! Function to calculate the ceiling of the binary logarithm of a given positive 
+ *  integer n. Returns -1 (standing for MINUS_INFINITY) for n = 0.
+ */
+static int log2ceil(unsigned int inpval)
+{
+  int logval = 0;
+
+  if (inpval == 0)
+  {
+    return (-1);
+  }
+  // inpval is positive
+  else
+  {
+    unsigned long long int max = 1; // exp=0 => max=2^0=1
+    // log computation loop
+    while (max < inpval)
+    {
+      // increment exponent
+      logval = logval + 1;
+      //  max = 2^logval
+      max = max * 2;
+    }
+  }
+
+  // exponent that gives (2^logval) >= inpval
+  return (logval);
+}
+
+/*! Calculate integer power supporting results up to 64-bits.
+ */
+unsigned long long int kdiv_ipowul(int base, int exponent)
+{
+  unsigned long long int temp;
+  int i;
+  
+  temp = 1;
+  
+  for (i = 0; i < exponent; i++)
+  {
+    temp *= (unsigned int)base;     
+  }
+
+  return (temp);
+}
+
+/*! Calculates the multiplicative inverse of an integer divisor for unsigned
+ *  division.
+ */
+struct mu kdiv_magicu(unsigned d, unsigned W) {
+                           // Must have 1 <= d <= 2**32-1.
+   int p;
+   unsigned nc, delta, q1, r1, q2, r2;
+   const unsigned mask = (unsigned)(kdiv_ipowul(2, W) - 1);  // 2**W - 1.
+   struct mu magu;
+
+   magu.a = 0;             // Initialize "add" indicator.
+   nc = mask - (mask + 1 - d)%d; // Unsigned arithmetic here, modulo 2**W.
+   p = W-1;                // Init. p.
+
+   q1 = (1u << (W-1))/nc;  // Init. q1 = 2**p/nc.
+   r1 = (1u << (W-1)) - q1*nc;// Init. r1 = rem(2**p, nc).
+   q2 = ((1u << (W-1))-1)/d;      // Init. q2 = (2**p - 1)/d.
+   r2 = ((1u << (W-1))-1) - q2*d; // Init. r2 = rem(2**p - 1, d).
+   do {
+      p = p + 1;
+      if (r1 >= nc - r1) {
+         q1 = 2*q1 + 1;            // Update q1.
+         r1 = 2*r1 - nc;}          // Update r1.
+      else {
+         q1 = 2*q1;
+         r1 = 2*r1;}
+      if (r2 + 1 >= d - r2) {
+         if (q2 >= (1u << (W-1))-1) magu.a = 1;
+         q2 = (2*q2 + 1) & mask;   // Update q2.
+         r2 = 2*r2 + 1 - d;}       // Update r2.
+      else {
+         if (q2 >= (1u << (W-1))) magu.a = 1;
+         q2 = (2*q2) & mask;
+         r2 = 2*r2 + 1;}
+      delta = d - 1 - r2;
+   } while (p < 2*(int)W &&
+           (q1 < delta || (q1 == delta && r1 == 0)));
+
+   magu.M = (q2 + 1) & mask; // Magic number
+   magu.s = p - W;         // and shift amount to return
+   return magu;            // (magu.a was set above).
+}
+
+/*! Calculates the multiplicative inverse of an integer divisor for signed
+ *  division.
+ */
+struct ms kdiv_magic(int d, unsigned W) {   // Must have 2 <= d <= 2**31-1
+                                       // or   -2**31 <= d <= -2.
+   int p;
+   unsigned ad, anc, delta, q1, r1, q2, r2, t;
+   const unsigned two31 = (1u << (W-1));    // 2**31 (2**(W-1)).
+   struct ms mag;
+
+   ad = abs(d);
+   t = two31 + ((unsigned)d >> 31);   // Sign bit of d, for any W.
+   anc = t - 1 - t%ad;     // Absolute value of nc.
+   p = W-1;                // Init. p.
+   q1 = two31/anc;         // Init. q1 = 2**p/|nc|.
+   r1 = two31 - q1*anc;    // Init. r1 = rem(2**p, |nc|).
+   q2 = two31/ad;          // Init. q2 = 2**p/|d|.
+   r2 = two31 - q2*ad;     // Init. r2 = rem(2**p, |d|).
+   do {
+      p = p + 1;
+      q1 = 2*q1;           // Update q1 = 2**p/|nc|.
+      r1 = 2*r1;           // Update r1 = rem(2**p, |nc|).
+      if (r1 >= anc) {     // (Must be an unsigned
+         q1 = q1 + 1;      // comparison here).
+         r1 = r1 - anc;}
+      q2 = 2*q2;           // Update q2 = 2**p/|d|.
+      r2 = 2*r2;           // Update r2 = rem(2**p, |d|).
+      if (r2 >= ad) {      // (Must be an unsigned
+         q2 = q2 + 1;      // comparison here).
+         r2 = r2 - ad;}
+      delta = ad - r2;
+   } while (q1 < delta || (q1 == delta && r1 == 0));
+
+   mag.M = q2 + 1;            // As a W-bit signed value.
+   if (q2 + 1 >= two31) mag.M = (int)(q2 + 1 - two31) - (int)(two31 - 1) - 1;
+   if (d < 0) mag.M = -mag.M; // Magic number and
+   mag.s = p - W;             // shift amount to return.
+   return mag;
+}
+
+/*! Return 1 if limb j of n takes part in a partial product of the plan.
+ */
+static int mulw_limb_used(const struct kdiv_mulw *w, int j)
+{
+  int i;
+  
+  for (i = 0; i < w->k; i++)
+  {
+    if ((w->Ml[i] != 0) && (i + j >= w->cd))
+    {
+      return (1);
+    }
+  }
+  return (0);
+}
+
+/*! Append the name suffix of routines with a decomposed high multiply.
+ */
+static void emit_mulw_suffix(struct kdiv_buf *f, const struct kdiv_mulw *w)
+{
+  if (w != NULL)
+  {
+    kdiv_bprintf(f, 0, "_m%u", w->mw);
+  }
+}
+
+/*! Return the signed magic number of a decomposition for signed division,
+ *  sign-extended from its W-bit pattern.
+ */
+static int mulw_magic(const struct kdiv_mulw *w)
+{
+  if (((w->M >> (w->W - 1)) & 1) != 0)
+  {
+    return ((int)((long long int)w->M - (long long int)kdiv_ipowul(2, w->W)));
+  }
+  return ((int)w->M);
+}
+
+/*! Emit the NAC declarations of the decomposed high multiply.
+ */
+static void emit_mulw_decl_nac(struct kdiv_buf *f, const struct kdiv_mulw *w)
+{
+  int j;
+  
+  kdiv_bprintf(f, 2, "localvar u%u ", w->mw);
+  for (j = 0; j < w->k; j++)
+  {
+    if (mulw_limb_used(w, j) == 1)
+    {
+      kdiv_bprintf(f, 0, "l%d, ", j);
+    }
+  }
+  kdiv_bprintf(f, 0, "ml;\n");
+  kdiv_bprintf(f, 2, "localvar u%u pp, ac, hc, pt;\n", 2*w->mw);
+  kdiv_bprintf(f, 2, "localvar u%u x;\n", w->W);
+}
+
+/*! Emit the NAC sequence of NOTES 9) computing the high word of M * src 
+ *  into dst (both u<W>).
+ */
+static void emit_mulhi_split_nac(struct kdiv_buf *f, const struct kdiv_mulw *w,
+  const char *src, const char *dst)
+{
+  unsigned int mask = (1u << w->mw) - 1;
+  int i, j, col, had;
+  
+  kdiv_bprintf(f, 2, "x <= mov %s;\n", src);
+  for (j = 0; j < w->k; j++)
+  {
+    if (mulw_limb_used(w, j) == 1)
+    {
+      kdiv_bprintf(f, 2, "l%d <= trunc x;\n", j);
+    }
+    if (j < w->k - 1)
+    {
+      kdiv_bprintf(f, 2, "x <= shr x, %u;\n", w->mw);
+    }
+  }
+  kdiv_bprintf(f, 2, "ac <= ldc %u;\n", w->cin);
+  kdiv_bprintf(f, 2, "hc <= ldc 0;\n");
+  for (col = w->cd; col < 2*w->k; col++)
+  {
+    had = 0;
+    for (i = 0; i < w->k; i++)
+    {
+      j = col - i;
+      if ((j >= 0) && (j < w->k) && (w->Ml[i] != 0))
+      {
+        kdiv_bprintf(f, 2, "ml <= ldc %u;\n", w->Ml[i]);
+        kdiv_bprintf(f, 2, "pp <= mul ml, l%d;\n", j);
+        kdiv_bprintf(f, 2, "pt <= and pp, %u;\n", mask);
+        kdiv_bprintf(f, 2, "ac <= add ac, pt;\n");
+        kdiv_bprintf(f, 2, "pt <= shr pp, %u;\n", w->mw);
+        kdiv_bprintf(f, 2, "hc <= add hc, pt;\n");
+        had = 1;
+      }
+    }
+    if (col >= w->k)
+    {
+      kdiv_bprintf(f, 2, "pt <= and ac, %u;\n", mask);
+      if (col == w->k)
+      {
+        kdiv_bprintf(f, 2, "%s <= %s pt;\n", dst, (2*w->mw == w->W) ? "mov" : "zxt");
+      }
+      else
+      {
+        kdiv_bprintf(f, 2, "x <= %s pt;\n", (2*w->mw == w->W) ? "mov" : "zxt");
+        kdiv_bprintf(f, 2, "x <= shl x, %u;\n", (col - w->k) * w->mw);
+        kdiv_bprintf(f, 2, "%s <= or %s, x;\n", dst, dst);
+      }
+    }
+    if (col < 2*w->k - 1)
+    {
+      kdiv_bprintf(f, 2, "ac <= shr ac, %u;\n", w->mw);
+      if (had == 1)
+      {
+        kdiv_bprintf(f, 2, "ac <= add ac, hc;\n");
+        kdiv_bprintf(f, 2, "hc <= ldc 0;\n");
+      }
+    }
+  }
+}
+
+/*! Return 1 if the W-bit operands of an ANSI C routine for a target with 
+ *  the multiplier of w are held in long: such targets may have a 16-bit 
+ *  int. long may also be wider than W bits, so these routines mask their
+ *  intermediate values to W bits.
+ */
+static int mulw_long(const struct kdiv_mulw *w, unsigned int W)
+{
+  return ((w != NULL) && (W > 16));
+}
+
+/*! Emit the ANSI C declarations of the decomposed high multiply.
+ */
+static void emit_mulw_decl_ansic(struct kdiv_buf *f, const struct kdiv_mulw *w)
+{
+  int j, n=0;
+  
+  kdiv_bprintf(f, 2, "unsigned int ");
+  for (j = 0; j < w->k; j++)
+  {
+    if (mulw_limb_used(w, j) == 1)
+    {
+      kdiv_bprintf(f, 0, "%sl%d", (n++ > 0) ? ", " : "", j);
+    }
+  }
+  kdiv_bprintf(f, 0, ";\n");
+  kdiv_bprintf(f, 2, "unsigned long int pp, ac, hc;\n");
+}
+
+/*! Emit the ANSI C sequence of NOTES 9) computing the high word of M * src
+ *  into dst (both holding W-bit values, see mulw_long). Every 
+ *  multiplication is an unsigned long int product of two mw-bit limbs.
+ */
+static void emit_mulhi_split_ansic(struct kdiv_buf *f, const struct kdiv_mulw *w,
+  const char *src, const char *dst)
+{
+  const char *T = (mulw_long(w, w->W) == 1) ? "unsigned long int" : "unsigned int";
+  unsigned int mask = (1u << w->mw) - 1;
+  int i, j, col, had;
+  
+  for (j = 0; j < w->k; j++)
+  {
+    if (mulw_limb_used(w, j) == 0)
+    {
+      continue;
+    }
+    if (j == 0)
+    {
+      kdiv_bprintf(f, 2, "l0 = %s & %uU;\n", src, mask);
+    }
+    else if ((j == w->k - 1) && (w->W == 32))
+    {
+      kdiv_bprintf(f, 2, "l%d = %s >> %u;\n", j, src, j * w->mw);
+    }
+    else
+    {
+      kdiv_bprintf(f, 2, "l%d = (%s >> %u) & %uU;\n", j, src, j * w->mw, mask);
+    }
+  }
+  kdiv_bprintf(f, 2, "ac = %uUL;\n", w->cin);
+  kdiv_bprintf(f, 2, "hc = 0;\n");
+  for (col = w->cd; col < 2*w->k; col++)
+  {
+    had = 0;
+    for (i = 0; i < w->k; i++)
+    {
+      j = col - i;
+      if ((j >= 0) && (j < w->k) && (w->Ml[i] != 0))
+      {
+        kdiv_bprintf(f, 2, "pp = (unsigned long int)%uU * l%d;\n", w->Ml[i], j);
+        kdiv_bprintf(f, 2, "ac = ac + (pp & %uU);\n", mask);
+        kdiv_bprintf(f, 2, "hc = hc + (pp >> %u);\n", w->mw);
+        had = 1;
+      }
+    }
+    if (col == w->k)
+    {
+      kdiv_bprintf(f, 2, "%s = (%s)(ac & %uU);\n", dst, T, mask);
+    }
+    else if (col > w->k)
+    {
+      kdiv_bprintf(f, 2, "%s = %s | ((%s)(ac & %uU) << %u);\n", 
+        dst, dst, T, mask, (col - w->k) * w->mw);
+    }
+    if (col < 2*w->k - 1)
+    {
+      if (had == 1)
+      {
+        kdiv_bprintf(f, 2, "ac = (ac >> %u) + hc;\n", w->mw);
+        kdiv_bprintf(f, 2, "hc = 0;\n");
+      }
+      else
+      {
+        kdiv_bprintf(f, 2, "ac = ac >> %u;\n", w->mw);
+      }
+    }
+  }
+}
+
+/*! 
+   NOTES on unsigned division by constant.
+1) Unsigned division by powers-of-2, with d = 2^k
+  shr   q, n, k
+
+2) Unsigned division with a = 0 (additive factor)
+  li    M, dinv             // dinv = multiplicative inverse of d 
+  mulhu q, M, n
+  shri  q, q, s             // s is the shift factor
+  
+3) Unsigned division with a = 1
+  li    M, dinv
+  mulhu q, M, n
+  add   q, q, n
+  shrxi q, q, s             // an extended shr immediate using the carry and 
+                            // q (concatenated); then performing logical shift
+*/     
+
+/*! Emit the NAC implementation of unsigned division by constant, with the
+ *  high multiply decomposed according to w if not NULL.
+ */
+static int kdiv_emit_u_nac_w(struct kdiv_buf *f, unsigned int M, int a, int s, 
+  unsigned int d, unsigned int W, const struct kdiv_mulw *w)
+{ 
+  int split = (w != NULL) && (w->nprod > 0);
+  
+  kdiv_bprintf(f, 0, "procedure kdiv_u%d_p_%d", W, d);
+  emit_mulw_suffix(f, w);
+  kdiv_bprintf(f, 0, " (in u%d n, out u%d y)\n", W, W);
+  kdiv_bprintf(f, 0, "{\n");   
+  kdiv_bprintf(f, 2, "localvar u%d q, M;\n", W);   
+  kdiv_bprintf(f, 2, "localvar u%d t0, t1;\n", 2*W);   
+  if (a == 1)
+  {
+    kdiv_bprintf(f, 2, "localvar u%d n0;\n", 2*W);   
+  }
+  if (split)
+  {
+    emit_mulw_decl_nac(f, w);
+  }
+  kdiv_bprintf(f, 0, "S_1:\n");
+  
+  if (ispowof2(d) == 1)
+  {
+    // shr   q, n, k
+    kdiv_bprintf(f, 2, "q <= shr n, %d;\n", log2ceil(d));
+  }
+  else if (a == 0)
+  {
+    // mulhu q, M, n
+    if (split)
+    {
+      emit_mulhi_split_nac(f, w, "n", "q");
+    }
+    else
+    {
+      kdiv_bprintf(f, 2, "M <= ldc %u;\n", M);
+      kdiv_bprintf(f, 2, "t0 <= mul M, n;\n");
+      kdiv_bprintf(f, 2, "t1 <= shr t0, %d;\n", W);
+      kdiv_bprintf(f, 2, "q <= trunc t1;\n");
+    }
+    // shri  q, q, s
+    kdiv_bprintf(f, 2, "q <= shr q, %d;\n", s);
+  }
+  else if (a == 1)
+  {
+    // mulhu q, M, n
+    if (split)
+    {
+      emit_mulhi_split_nac(f, w, "n", "q");
+    }
+    else
+    {
+      kdiv_bprintf(f, 2, "M <= ldc %u;\n", M);
+      kdiv_bprintf(f, 2, "t0 <= mul M, n;\n");
+      kdiv_bprintf(f, 2, "t1 <= shr t0, %d;\n", W);
+      kdiv_bprintf(f, 2, "q <= trunc t1;\n");
+    }
+    // add   q, q, n
+    // t = q + n;
+    // q = t & 0xFFFFFFFF;
+    kdiv_bprintf(f, 2, "t0 <= zxt q;\n");
+    kdiv_bprintf(f, 2, "n0 <= zxt n;\n");
+    kdiv_bprintf(f, 2, "t0 <= add t0, n0;\n");
+    // shrxi q, q, s        // an extended shr immediate using the carry and 
+                            // q (concatenated); then performing logical shift  
+    kdiv_bprintf(f, 2, "t0 <= shr t0, %d;\n", s);
+    kdiv_bprintf(f, 2, "q <= trunc t0;\n");    
+  }
+  else
+  {
+    return (KDIV_E_UNSUPPORTED);
+  }  
+  kdiv_bprintf(f, 2, "y <= mov q;\n");
+  return (kdiv_bprintf(f, 0, "}\n")); 
+}
+
+/*! Emit the NAC (generic assembly language) implementation of unsigned division 
+ *  by constant.
+ */
+static int emit_kdivu_nac(struct kdiv_buf *f, unsigned int M, int a, int s, unsigned int d, unsigned int W)
+{
+  return (kdiv_emit_u_nac_w(f, M, a, s, d, W, NULL));
+}
+
+/*! Emit the NAC implementation of unsigned division by constant with the 
+ *  high multiply decomposed according to w (see kdiv_mulw_u).
+ */
+static int emit_kdivu_mulw_nac(struct kdiv_buf *f, const struct kdiv_mulw *w)
+{
+  return (kdiv_emit_u_nac_w(f, w->M, w->a, w->s, (unsigned int)w->d, w->W, w));
+}
+
+/*! Emit the ANSI C implementation of unsigned division by constant, with 
+ *  the high multiply decomposed according to w if not NULL.
+ */
+static int kdiv_emit_u_ansic_w(struct kdiv_buf *f, unsigned int M, int a, int s, 
+  unsigned int d, unsigned int W, const struct kdiv_mulw *w)
+{
+  int split = (w != NULL) && (w->nprod > 0);
+  const char *T = (mulw_long(w, W) == 1) ? "unsigned long int" : "unsigned int";
+  const char *U = (mulw_long(w, W) == 1) ? "UL" : "U";
+  
+  kdiv_bprintf(f, 0, "%s kdiv_u%d_p_%d", T, W, d);
+  emit_mulw_suffix(f, w);
+  kdiv_bprintf(f, 0, " (%s n)\n", T);
+  kdiv_bprintf(f, 0, "{\n");   
+  if (split)
+  {
+    kdiv_bprintf(f, 2, "%s q%s;\n", T, (a == 1) ? ", t" : "");
+    emit_mulw_decl_ansic(f, w);
+  }
+  else if (ispowof2(d) == 1)
+  {
+    kdiv_bprintf(f, 2, "%s q;\n", T);   
+  }
+  else
+  {
+    kdiv_bprintf(f, 2, "unsigned int q, M=%u;\n", M);   
+    kdiv_bprintf(f, 2, "unsigned long long int t;\n");   
+  }
+  
+  if (ispowof2(d) == 1)
+  {
+    kdiv_bprintf(f, 2, "q = n >> %d;\n", log2ceil(d));
+  }
+  else if (a == 0)
+  {
+    // mulhu q, M, n
+    if (split)
+    {
+      emit_mulhi_split_ansic(f, w, "n", "q");
+    }
+    else
+    {
+      kdiv_bprintf(f, 2, "t = (unsigned long long int)M * (unsigned long long int)n;\n");
+      kdiv_bprintf(f, 2, "q = t >> %d;\n", W);
+    }
+    if (s > 0)
+    {
+      // shri  q, q, s
+      kdiv_bprintf(f, 2, "q = q >> %d;\n", s);
+    }
+  }
+  else if (a == 1)
+  {
+    // mulhu q, M, n
+    if (split)
+    {
+      emit_mulhi_split_ansic(f, w, "n", "q");
+    }
+    else
+    {
+      kdiv_bprintf(f, 2, "t = (unsigned long long int)M * (unsigned long long int)n;\n");
+      kdiv_bprintf(f, 2, "q = t >> %d;\n", W);    
+    }
+    if (split)
+    {
+      // add   q, q, n      // W-bit sum; its carry out is t < n
+      kdiv_bprintf(f, 2, "t = (q + n) & 0x%llX%s;\n", kdiv_ipowul(2, W)-1, U);
+      // shrxi q, q, s      // shifting the carry in as bit W-s
+      if (s > 0)
+      {
+        kdiv_bprintf(f, 2, "q = (t >> %d) | ((%s)(t < n) << %d);\n", s, T, W-s);
+      }
+      else
+      {
+        kdiv_bprintf(f, 2, "q = t;\n");
+      }
+    }
+    else
+    {
+      // add   q, q, n      // keeping the carry out of the W-bit sum
+      kdiv_bprintf(f, 2, "t = (unsigned long long int)q + n;\n");
+      // shrxi q, q, s      // an extended shr immediate using the carry and 
+                            // q (concatenated); then performing logical shift  
+      if (s > 0)
+      {
+        kdiv_bprintf(f, 2, "q = t >> %d;\n", s);
+      }
+      else
+      {
+        kdiv_bprintf(f, 2, "q = t & 0x%llXU;\n", kdiv_ipowul(2, W)-1);
+      }
+    }
+  }
+  else
+  {
+    return (KDIV_E_UNSUPPORTED);
+  }  
+  kdiv_bprintf(f, 2, "return (q);\n");
+  return (kdiv_bprintf(f, 0, "}\n"));
+}
+
+/*! Emit the ANSI C implementation of unsigned division by constant.
+ */                       
+static int emit_kdivu_ansic(struct kdiv_buf *f, unsigned int M, int a, int s, unsigned int d, unsigned int W)
+{
+  return (kdiv_emit_u_ansic_w(f, M, a, s, d, W, NULL));
+}
+
+/*! Emit the ANSI C implementation of unsigned division by constant with the
+ *  high multiply decomposed according to w (see kdiv_mulw_u).
+ */
+static int emit_kdivu_mulw_ansic(struct kdiv_buf *f, const struct kdiv_mulw *w)
+{
+  return (kdiv_emit_u_ansic_w(f, w->M, w->a, w->s, (unsigned int)w->d, w->W, w));
+}
+
+/*! Perform an unsigned division by constant according to "Hacker's Delight"
+ *  routines. Any nonzero "add" indicator selects the add-and-carry path.
+ */
+unsigned int kdiv_calculate_u(unsigned int M, int a, int s, unsigned int n, unsigned int d, unsigned int W)
+{
+  unsigned long long int t;
+  unsigned int q;
+  
+  if (ispowof2(d) == 1)
+  {
+    // shr   q, n, k
+    q = n >> log2ceil(d);  // NOTE: log2ceil() accepts int and not unsigned int.
+  }
+  else if (a == 0)
+  {
+    // mulhu q, M, n
+    t = (unsigned long long int)M * (unsigned long long int)n;
+    q = t >> W;
+    // shri  q, q, s
+    q = q >> s;
+  }
+  else
+  {
+    // mulhu q, M, n
+    t = (unsigned long long int)M * (unsigned long long int)n;
+    q = t >> W;    
+    // add   q, q, n        // keeping the carry out of the W-bit sum
+    t = (unsigned long long int)q + n;
+    // shrxi q, q, s        // an extended shr immediate using the carry and 
+                            // q (concatenated); then performing logical shift  
+    q = t >> s;    
+  }
+  return (q);
+}
+
+/*!
+   NOTES on signed division by constant.
+4) Signed division for non-powers-of-2
+  li    M, dinv
+  mulhs q, M, n
+  add   q, q, n             // correction term only for d = 7
+  shrsi q, q, s
+  shri  t, n, W-1           // W is the word length; for negative divisors 
+                            // (d < 0) the sign of q is used instead of n
+  add   q, q, t
+
+5) Signed division by powers-of-2, with d = 2^k
+  shrsi t, n, k-1
+  shri  t, t, W-k
+  add   t, n, t
+  shrsi q, t, k
+  neg   q, q                // for negative divisors (d < 0)
+*/     
+
+/*! Emit the NAC implementation of signed division by constant, with the
+ *  high multiply decomposed according to w if not NULL.
+ */
+static int kdiv_emit_s_nac_w(struct kdiv_buf *f, int M, int s, int d, 
+  unsigned int W, const struct kdiv_mulw *w)
+{
+  int split = (w != NULL) && (w->nprod > 0);
+  int k;
+  
+  kdiv_bprintf(f, 0, "procedure kdiv_s%d_", W);
+  if (d < 0)
+  {
+    kdiv_bprintf(f, 0, "m_");
+  }
+  else
+  {
+    kdiv_bprintf(f, 0, "p_");
+  }
+  kdiv_bprintf(f, 0, "%d", ABS(d));
+  emit_mulw_suffix(f, w);
+  kdiv_bprintf(f, 0, " (in s%u n, out s%u y)\n", W, W);
+  kdiv_bprintf(f, 0, "{\n");   
+  kdiv_bprintf(f, 2, "localvar s%u q, M, c;\n", W);   
+  kdiv_bprintf(f, 2, "localvar s%u t, u, v;\n", 2*W);   
+  if (split)
+  {
+    kdiv_bprintf(f, 2, "localvar u%u nu, hu;\n", W);
+    emit_mulw_decl_nac(f, w);
+  }
+  kdiv_bprintf(f, 0, "S_1:\n");
+  
+  k = log2ceil(ABS(d));
+  if (d == 1)
+  {
+    // mov q, n
+    kdiv_bprintf(f, 2, "q <= mov n;\n");
+  }
+  else if (d == -1)
+  {
+    // neg q, n
+    kdiv_bprintf(f, 2, "q <= neg n;\n");
+  }
+  else if (ispowof2(d) == 1)
+  {
+    // shrsi t, n, k-1
+    kdiv_bprintf(f, 2, "t <= sxt n;\n");
+    kdiv_bprintf(f, 2, "t <= shr t, %d;\n", k-1);   
+    // shri  t, t, W-k
+    kdiv_bprintf(f, 2, "u <= shr t, %d;\n", W-k);
+    kdiv_bprintf(f, 2, "u <= and u, %u;\n", (unsigned int)(kdiv_ipowul(2, k)-1));
+    // add   t, n, t
+    kdiv_bprintf(f, 2, "v <= sxt n;\n");
+    kdiv_bprintf(f, 2, "t <= add v, u;\n");
+    // shrsi q, t, k
+    kdiv_bprintf(f, 2, "t <= shr t, %d;\n", k);
+    kdiv_bprintf(f, 2, "q <= trunc t;\n");
+    // neg   q, q                // for negative divisors (d < 0)
+    if (d < 0)
+    {
+      kdiv_bprintf(f, 2, "q <= neg q;\n");
+    }
+  }
+  else
+  {
+    // mulhs q, M, n
+    if (split)
+    {
+      // mulhu of the W-bit patterns, less n for M < 0 and M for n < 0
+      kdiv_bprintf(f, 2, "nu <= mov n;\n");
+      emit_mulhi_split_nac(f, w, "nu", "hu");
+      if (M < 0)
+      {
+        kdiv_bprintf(f, 2, "hu <= sub hu, nu;\n");
+      }
+      kdiv_bprintf(f, 2, "x <= shr nu, %d;\n", W-1);
+      kdiv_bprintf(f, 2, "x <= neg x;\n");
+      kdiv_bprintf(f, 2, "x <= and x, %u;\n", w->M);
+      kdiv_bprintf(f, 2, "hu <= sub hu, x;\n");
+      kdiv_bprintf(f, 2, "q <= mov hu;\n");
+    }
+    else
+    {
+      kdiv_bprintf(f, 2, "M <= ldc %d;\n", M);
+      kdiv_bprintf(f, 2, "t <= mul M, n;\n");    
+      kdiv_bprintf(f, 2, "u <= shr t, %d;\n", W);
+      kdiv_bprintf(f, 2, "q <= trunc u;\n");    
+    }
+    // add|sub  q, q, n             // correction term for certain divisors
+    if ((d > 0) && (M < 0))
+    {
+      kdiv_bprintf(f, 2, "q <= add q, n;\n");
+    }    
+    else if ((d < 0) && (M > 0))
+    {
+      kdiv_bprintf(f, 2, "q <= sub q, n;\n");
+    }
+    // shrsi q, q, s
+    if (s > 0)
+    {
+      kdiv_bprintf(f, 2, "q <= shr q, %d;\n", s);
+    }
+    // shri  t, n, W-1           // W is the word length; q for d < 0
+    kdiv_bprintf(f, 2, "c <= shr %c, %d;\n", (d < 0) ? 'q' : 'n', W-1);
+    kdiv_bprintf(f, 2, "c <= and c, 1;\n");
+    // add   q, q, t
+    kdiv_bprintf(f, 2, "q <= add q, c;\n");
+  }
+  kdiv_bprintf(f, 2, "y <= mov q;\n");
+  return (kdiv_bprintf(f, 0, "}\n")); 
+}
+
+/*! Emit the NAC (generic assembly language) implementation of signed division 
+ *  by constant.
+ */                       
+static int emit_kdivs_nac(struct kdiv_buf *f, int M, int s, int d, unsigned int W)
+{
+  return (kdiv_emit_s_nac_w(f, M, s, d, W, NULL));
+}
+
+/*! Emit the NAC implementation of signed division by constant with the 
+ *  high multiply decomposed according to w (see kdiv_mulw_s).
+ */
+static int emit_kdivs_mulw_nac(struct kdiv_buf *f, const struct kdiv_mulw *w)
+{
+  return (kdiv_emit_s_nac_w(f, mulw_magic(w), w->s, (int)w->d, w->W, w));
+}
+
+/*! Emit the ANSI C implementation of signed division by constant, with the
+ *  high multiply decomposed according to w if not NULL.
+ */
+static int kdiv_emit_s_ansic_w(struct kdiv_buf *f, int M, int s, int d, 
+  unsigned int W, const struct kdiv_mulw *w)
+{
+  int split = (w != NULL) && (w->nprod > 0);
+  const char *T = (mulw_long(w, W) == 1) ? "unsigned long int" : "unsigned int";
+  const char *ST = (mulw_long(w, W) == 1) ? "signed long int" : "signed int";
+  const char *U = (mulw_long(w, W) == 1) ? "UL" : "U";
+  int k;
+  
+  kdiv_bprintf(f, 0, "%s kdiv_s%d_", ST, W);
+  if (d < 0)
+  {
+    kdiv_bprintf(f, 0, "m_");
+  }
+  else
+  {
+    kdiv_bprintf(f, 0, "p_");
+  }
+  kdiv_bprintf(f, 0, "%d", ABS(d));
+  emit_mulw_suffix(f, w);
+  kdiv_bprintf(f, 0, " (%s n)\n", ST);
+  kdiv_bprintf(f, 0, "{\n");   
+  if (split)
+  {
+    kdiv_bprintf(f, 2, "%s q;\n", ST);
+    kdiv_bprintf(f, 2, "signed int c;\n");
+    kdiv_bprintf(f, 2, "%s nu, hu;\n", T);
+    emit_mulw_decl_ansic(f, w);
+  }
+  else if (ABS(d) == 1)
+  {
+    kdiv_bprintf(f, 2, "%s q;\n", ST);   
+  }
+  else if ((ispowof2(d) == 1) && (w != NULL))
+  {
+    kdiv_bprintf(f, 2, "%s q, t;\n", ST);   
+    kdiv_bprintf(f, 2, "%s u;\n", T);   
+  }
+  else if (ispowof2(d) == 1)
+  {
+    kdiv_bprintf(f, 2, "signed int q;\n");   
+    kdiv_bprintf(f, 2, "signed long long int t, u;\n");   
+  }
+  else
+  {
+    kdiv_bprintf(f, 2, "signed int q, M=%d, c;\n", M);   
+    kdiv_bprintf(f, 2, "signed long long int t;\n");   
+  }
+
+  k = log2ceil(ABS(d));
+  if (d == 1)
+  {
+    kdiv_bprintf(f, 2, "q = n;\n");
+  }
+  else if (d == -1)
+  {
+    kdiv_bprintf(f, 2, "q = -n;\n");
+  }
+  else if (ispowof2(d) == 1)
+  {
+    // shrsi t, n, k-1
+    kdiv_bprintf(f, 2, "t = n >> %d;\n", k-1);
+    // shri  t, t, W-k
+    if (w != NULL)
+    {
+      kdiv_bprintf(f, 2, "u = ((%s)t & 0x%llX%s) >> %d;\n", T, kdiv_ipowul(2, W)-1, U, W-k);
+      // add   t, n, t
+      kdiv_bprintf(f, 2, "t = n + (%s)u;\n", ST);
+    }
+    else
+    {
+      kdiv_bprintf(f, 2, "u = (unsigned int)t >> %d;\n", W-k);
+      // add   t, n, t
+      kdiv_bprintf(f, 2, "t = n + u;\n");
+    }
+    // shrsi q, t, k
+    kdiv_bprintf(f, 2, "q = t >> %d;\n", k);
+    // neg   q, q                // for negative divisors (d < 0)
+    if (d < 0)
+    {
+      kdiv_bprintf(f, 2, "q = -q;\n");
+    }
+  }
+  else
+  {
+    // mulhs q, M, n
+    if (split)
+    {
+      // mulhu of the W-bit patterns, less n for M < 0 and M for n < 0
+      kdiv_bprintf(f, 2, "nu = (%s)n & 0x%llX%s;\n", T, kdiv_ipowul(2, W)-1, U);
+      emit_mulhi_split_ansic(f, w, "nu", "hu");
+      if (M < 0)
+      {
+        kdiv_bprintf(f, 2, "hu = (hu - nu) & 0x%llX%s;\n", kdiv_ipowul(2, W)-1, U);
+      }
+      kdiv_bprintf(f, 2, "hu = (hu - (%u%s & (0%s - (nu >> %d)))) & 0x%llX%s;\n", 
+        w->M, U, U, W-1, kdiv_ipowul(2, W)-1, U);
+      // the W-bit pattern as a signed value, without overflow in the cast
+      kdiv_bprintf(f, 2, "q = (hu >> %d) ? (%s)(hu - 0x%llX%s) - 0x%llX%s - 1 : (%s)hu;\n", 
+        W-1, ST, kdiv_ipowul(2, W-1), U, kdiv_ipowul(2, W-1)-1, (mulw_long(w, W) == 1) ? "L" : "", ST);
+    }
+    else
+    {
+      kdiv_bprintf(f, 2, "t = (signed long long int)M * (signed long long int)n;\n");
+      kdiv_bprintf(f, 2, "q = t >> %d;\n", W);   
+    }
+    // add|sub  q, q, n             // correction term for certain divisors
+    if ((d > 0) && (M < 0))
+    {
+      kdiv_bprintf(f, 2, "q = q + n;\n");
+    }    
+    else if ((d < 0) && (M > 0))
+    {
+      kdiv_bprintf(f, 2, "q = q - n;\n");
+    }
+    if (s > 0)
+    {
+      // shrsi q, q, s
+      kdiv_bprintf(f, 2, "q = q >> %d;\n", s);
+    }
+    // shri  t, n, W-1           // W is the word length; q for d < 0
+    if (split)
+    {
+      kdiv_bprintf(f, 2, "c = (%c < 0);\n", (d < 0) ? 'q' : 'n');
+    }
+    else
+    {
+      kdiv_bprintf(f, 2, "c = (unsigned int)%c >> %d;\n", (d < 0) ? 'q' : 'n', W-1);
+    }
+    // add   q, q, t
+    kdiv_bprintf(f, 2, "q = q + c;\n");
+  }
+  kdiv_bprintf(f, 2, "return (q);\n");
+  return (kdiv_bprintf(f, 0, "}\n"));
+}
+
+/*! Emit the ANSI C implementation of signed division by constant.
+ */  
+static int emit_kdivs_ansic(struct kdiv_buf *f, int M, int s, int d, unsigned int W)
+{
+  return (kdiv_emit_s_ansic_w(f, M, s, d, W, NULL));
+}
+
+/*! Emit the ANSI C implementation of signed division by constant with the 
+ *  high multiply decomposed according to w (see kdiv_mulw_s).
+ */
+static int emit_kdivs_mulw_ansic(struct kdiv_buf *f, const struct kdiv_mulw *w)
+{
+  return (kdiv_emit_s_ansic_w(f, mulw_magic(w), w->s, (int)w->d, w->W, w));
+}
+
+/* kdiv_calculate_s:
+ * Perform a signed division by constant according to "Hacker's Delight" 
+ * routines.
+ */
+int kdiv_calculate_s(int M, int s, int n, int d, unsigned int W)
+{
+  signed long long int t, u;
+  int q;
+  int k;
+  unsigned int c;
+  
+  k = log2ceil(ABS(d));
+  if (d == 1)
+  {
+    q = n;
+  }
+  else if (d == -1)
+  {
+    q = -n;
+  }
+  else if (ispowof2(d) == 1)
+  {
+    // shrsi t, n, k-1
+    t = n >> (k-1);
+    // shri  t, t, W-k           // logical shift of the W-bit value
+    u = (t & (kdiv_ipowul(2, W) - 1)) >> (W-k);
+    // add   t, n, t
+    t = n + u;
+    // shrsi q, t, k
+    q = t >> k;
+    // neg   q, q                // for negative divisors (d < 0)
+    if (d < 0)
+    {
+      q = -q;
+    }
+  }
+  else
+  {
+    // To use the results of this program, the compiler should generate the 
+    // li and mulhs instructions, generate the add if d > 0 and M < 0, or 
+    // the sub if d < 0 and M > 0, and generate the shrsi if s > 0. Then, 
+    // the shri and final add must be generated.  
+    // mulhs q, M, n
+    t = (signed long long int)M * (signed long long int)n;
+    q = t >> W;   
+    // add|sub  q, q, n             // correction term for certain divisors
+    if ((d > 0) && (M < 0))
+    {
+      q = q + n;
+    }    
+    else if ((d < 0) && (M > 0))
+    {
+      q = q - n;
+    }
+    // shrsi q, q, s
+    q = q >> s;
+    // shri  t, n, W-1           // W is the word length; q for d < 0
+    c = ((unsigned int)((d < 0) ? q : n) >> (W-1)) & 1;
+    // add   q, q, t
+    q = q + c;
+  }
+  return (q);
+}
+
+
+/*! Calculate the cost metrics of the unsigned division routine for d. The 
+ *  operations follow NOTES 1) to 3).
+ */
+int kdiv_stats_u(struct kdiv_stats *st, unsigned int d, unsigned int W)
+{
+  struct mu magu;
+  
+  if (st == NULL)
+  {
+    return (KDIV_E_ARG);
+  }
+  // Same checks as kdiv_check, for the full unsigned divisor range.
+  if (d == 0)
+  {
+    return (KDIV_E_DIVZERO);
+  }
+  if ((W < 2) || (W > 32))
+  {
+    return (KDIV_E_WIDTH);
+  }
+  if ((unsigned long long int)d > kdiv_ipowul(2, W) - 1)
+  {
+    return (KDIV_E_RANGE);
+  }
+  memset(st, 0, sizeof(*st));
+  
+  if (ispowof2(d) == 1)
+  {
+    // shr   q, n, k
+    st->pow2  = 1;
+    st->shift = (d > 1);
+    st->ops   = st->shift;
+    st->depth = st->shift;
+    st->lat   = st->depth;
+    return (KDIV_OK);
+  }
+  magu = kdiv_magicu(d, W);
+  st->add   = (magu.a != 0);
+  st->shift = (magu.s > 0);
+  st->muls  = 1;
+  // li, mulhu [, add] [, shri/shrxi]
+  st->ops   = 2 + st->add + st->shift;
+  st->depth = 1 + st->add + st->shift;
+  st->lat   = st->depth + KDIV_LAT_MUL - 1;
+  return (KDIV_OK);
+}
+
+/*! Calculate the cost metrics of the signed division routine for d. The 
+ *  operations follow NOTES 4) and 5).
+ */
+int kdiv_stats_s(struct kdiv_stats *st, int d, unsigned int W)
+{
+  struct ms mags;
+  int err;
+  
+  if (st == NULL)
+  {
+    return (KDIV_E_ARG);
+  }
+  err = kdiv_check(d, W, 1);
+  if (err != KDIV_OK)
+  {
+    return (err);
+  }
+  memset(st, 0, sizeof(*st));
+  
+  if (d == 1)
+  {
+    // mov q, n
+    st->pow2 = 1;
+  }
+  else if (d == -1)
+  {
+    // neg q, n
+    st->ops   = 1;
+    st->depth = 1;
+  }
+  else if (ispowof2(d) == 1)
+  {
+    // shrsi, shri, add, shrsi
+    st->pow2  = 1;
+    st->shift = 1;
+    st->ops   = 4;
+    st->depth = 4;
+  }
+  else
+  {
+    mags = kdiv_magic(d, W);
+    st->fixup = ((d > 0) && (mags.M < 0)) || ((d < 0) && (mags.M > 0));
+    st->shift = (mags.s > 0);
+    st->muls  = 1;
+    // li, mulhs [, add|sub] [, shrsi], shri, add
+    st->ops   = 4 + st->fixup + st->shift;
+    // The shri of the sign of n runs in parallel to mulhs; for d < 0 it 
+    // takes the sign of q and is on the critical path.
+    st->depth = 2 + st->fixup + st->shift + ((d < 0) ? 1 : 0);
+  }
+  // mulhs is the first operation of the critical path.
+  st->lat = st->depth + st->muls * (KDIV_LAT_MUL - 1);
+  return (KDIV_OK);
+}
+
+/* Unsigned 128-bit integer, for the exact error bounds of the proofs. */
+struct u128 {
+  unsigned long long int hi, lo;
+};
+
+/*! Return the 128-bit product of two 64-bit unsigned integers.
+ */
+static struct u128 u128_mul(unsigned long long int a, unsigned long long int b)
+{
+  unsigned long long int a0 = a & 0xFFFFFFFFULL, a1 = a >> 32;
+  unsigned long long int b0 = b & 0xFFFFFFFFULL, b1 = b >> 32;
+  unsigned long long int p00, p01, p10, p11, mid;
+  struct u128 r;
+  
+  p00 = a0 * b0;
+  p01 = a0 * b1;
+  p10 = a1 * b0;
+  p11 = a1 * b1;
+  mid  = (p00 >> 32) + (p01 & 0xFFFFFFFFULL) + (p10 & 0xFFFFFFFFULL);
+  r.lo = (mid << 32) | (p00 & 0xFFFFFFFFULL);
+  r.hi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+  return (r);
+}
+
+/*! Return x * 2^p for p < 128 (modulo 2^128).
+ */
+static struct u128 u128_shl(unsigned long long int x, int p)
+{
+  struct u128 r;
+  
+  if (p == 0)
+  {
+    r.hi = 0;
+    r.lo = x;
+  }
+  else if (p < 64)
+  {
+    r.hi = x >> (64 - p);
+    r.lo = x << p;
+  }
+  else
+  {
+    r.hi = x << (p - 64);
+    r.lo = 0;
+  }
+  return (r);
+}
+
+static struct u128 u128_add(struct u128 a, struct u128 b)
+{
+  struct u128 r;
+  
+  r.lo = a.lo + b.lo;
+  r.hi = a.hi + b.hi + (r.lo < a.lo);
+  return (r);
+}
+
+static struct u128 u128_sub(struct u128 a, struct u128 b)
+{
+  struct u128 r;
+  
+  r.lo = a.lo - b.lo;
+  r.hi = a.hi - b.hi - (a.lo < b.lo);
+  return (r);
+}
+
+static int u128_cmp(struct u128 a, struct u128 b)
+{
+  if (a.hi != b.hi)
+  {
+    return ((a.hi < b.hi) ? -1 : 1);
+  }
+  return ((a.lo < b.lo) ? -1 : (a.lo > b.lo) ? 1 : 0);
+}
+
+/*! Check the Granlund-Montgomery bounds (see struct kdiv_cert) for the 
+ *  multiplier m and shift p over the dividends 0..nmax. Strict bounds apply 
+ *  when the quotient is rounded down, non-strict ones when it is rounded up
+ *  by a final +1 correction. Returns 1 when they hold.
+ */
+static int check_bound(unsigned long long int m, unsigned long long int d, 
+  int p, unsigned long long int nmax, int strict, unsigned long long int *e, 
+  unsigned long long int *nc)
+{
+  struct u128 pw, md, err, lhs, rhs;
+  int cmp;
+  
+  pw = u128_shl(1, p);
+  md = u128_mul(m, d);
+  if (u128_cmp(md, pw) < 0)
+  {
+    return (0);
+  }
+  err = u128_sub(md, pw);
+  if (err.hi != 0)
+  {
+    return (0);
+  }
+  *e = err.lo;
+  if ((strict == 0) && (*e == 0))
+  {
+    return (0);
+  }
+  // nc: largest n <= nmax with n mod d = d-1.
+  *nc = (nmax + 1 >= d) ? nmax - (nmax + 1) % d : 0;
+  if (nmax + 1 >= d)
+  {
+    lhs = u128_mul(*e, *nc);
+    cmp = u128_cmp(lhs, pw);
+    if ((cmp > 0) || ((strict == 1) && (cmp == 0)))
+    {
+      return (0);
+    }
+  }
+  lhs = u128_add(u128_mul(*e, nmax), u128_shl(nmax % d, p));
+  rhs = u128_shl(d, p);
+  cmp = u128_cmp(lhs, rhs);
+  if ((cmp > 0) || ((strict == 1) && (cmp == 0)))
+  {
+    return (0);
+  }
+  return (1);
+}
+
+/*! Prove that the unsigned division routine for d is exact for every W-bit 
+ *  dividend. Returns KDIV_OK, KDIV_E_PROOF if it is not, or an argument 
+ *  error; c receives the certificate in all but the last case.
+ */
+int kdiv_prove_u(struct kdiv_cert *c, unsigned int d, unsigned int W)
+{
+  struct kdiv_stats st;
+  struct mu magu;
+  unsigned long long int nmax, n, spots[8];
+  int err, i;
+  
+  if (c == NULL)
+  {
+    return (KDIV_E_ARG);
+  }
+  err = kdiv_stats_u(&st, d, W);
+  if (err != KDIV_OK)
+  {
+    return (err);
+  }
+  memset(c, 0, sizeof(*c));
+  c->d = d;
+  nmax = kdiv_ipowul(2, W) - 1;
+  
+  if (st.pow2 == 1)
+  {
+    // shr q, n, k is exact by construction: it is the multiply by 
+    // m = 2^W with p = W + k, and e = 0.
+    c->ok = 1;
+    magu.M = 0;
+    magu.a = 0;
+    magu.s = log2ceil(d);
+    c->s = magu.s;
+    c->p = W + magu.s;
+    c->m = kdiv_ipowul(2, W);
+  }
+  else
+  {
+    magu = kdiv_magicu(d, W);
+    c->M = magu.M;
+    c->a = magu.a;
+    c->s = magu.s;
+    c->p = W + magu.s;
+    c->m = magu.M + ((magu.a != 0) ? kdiv_ipowul(2, W) : 0);
+    c->ok = (magu.M <= nmax) && 
+            check_bound(c->m, d, c->p, nmax, 1, &c->e, &c->nc[0]);
+  }
+  
+  // Evaluate the reference sequence at the dividends the bounds hinge on;
+  // for a == 1 the largest ones also exercise the carry of the add.
+  spots[0] = 0;
+  spots[1] = d - 1;
+  spots[2] = d;
+  spots[3] = c->nc[0];
+  spots[4] = (c->nc[0] < nmax) ? c->nc[0] + 1 : nmax;
+  spots[5] = nmax - d + 1;
+  spots[6] = nmax - 1;
+  spots[7] = nmax;
+  for (i = 0; i < 8; i++)
+  {
+    n = spots[i];
+    if (kdiv_calculate_u(magu.M, magu.a, magu.s, n, d, W) != n / d)
+    {
+      c->spot++;
+    }
+  }
+  if (c->spot > 0)
+  {
+    c->ok = 0;
+  }
+  return ((c->ok == 1) ? KDIV_OK : KDIV_E_PROOF);
+}
+
+/*! Prove that the signed division routine for d is exact for every W-bit 
+ *  dividend, except for the overflowing -2^(W-1) / -1. Returns as 
+ *  kdiv_prove_u.
+ */
+int kdiv_prove_s(struct kdiv_cert *c, int d, unsigned int W)
+{
+  struct kdiv_stats st;
+  struct ms mags;
+  long long int nmin, nmax, n, spots[14];
+  unsigned long long int ad, mm;
+  long long int m;
+  int err, i, pos, neg;
+  
+  if (c == NULL)
+  {
+    return (KDIV_E_ARG);
+  }
+  err = kdiv_stats_s(&st, d, W);
+  if (err != KDIV_OK)
+  {
+    return (err);
+  }
+  memset(c, 0, sizeof(*c));
+  c->d = d;
+  ad = (d < 0) ? -(long long int)d : d;
+  nmax = kdiv_ipowul(2, W-1) - 1;
+  nmin = -nmax - 1;
+  mags.M = 0;
+  mags.s = 0;
+  
+  if (st.muls == 0)
+  {
+    // mov, neg and the shift sequence of NOTES 5) are exact by construction;
+    // as for kdiv_prove_u, they multiply by m = 2^W with p = W + k.
+    c->ok = 1;
+    c->s = log2ceil(ad);
+    c->p = W + c->s;
+    c->m = kdiv_ipowul(2, W);
+  }
+  else
+  {
+    mags = kdiv_magic(d, W);
+    c->M = (unsigned int)mags.M & (unsigned int)(kdiv_ipowul(2, W) - 1);
+    c->s = mags.s;
+    c->p = W + mags.s;
+    m = mags.M;
+    if ((d > 0) && (mags.M < 0))
+    {
+      c->a = 1;
+      m = m + (long long int)kdiv_ipowul(2, W);
+    }
+    else if ((d < 0) && (mags.M > 0))
+    {
+      c->a = -1;
+      m = m - (long long int)kdiv_ipowul(2, W);
+    }
+    mm = (m < 0) ? -m : m;
+    c->m = mm;
+    // The quotient is rounded down for dividends of the divisor's sign and 
+    // rounded up (by the sign correction) for the others.
+    pos = check_bound(mm, ad, c->p, (d > 0) ? nmax : -nmin, 1, &c->e, &c->nc[0]);
+    neg = check_bound(mm, ad, c->p, (d > 0) ? -nmin : nmax, 0, &c->e, &c->nc[1]);
+    c->ok = ((m > 0) == (d > 0)) && (pos == 1) && (neg == 1) &&
+            (mags.M >= -(long long int)kdiv_ipowul(2, W-1)) && 
+            (mags.M < (long long int)kdiv_ipowul(2, W-1));
+  }
+  
+  spots[0]  = 0;
+  spots[1]  = 1;
+  spots[2]  = -1;
+  spots[3]  = ad - 1;
+  spots[4]  = ad;
+  spots[5]  = -(long long int)ad;
+  spots[6]  = -(long long int)ad + 1;
+  spots[7]  = nmax;
+  spots[8]  = nmin;
+  spots[9]  = nmin + 1;
+  spots[10] = (long long int)c->nc[0] * ((d > 0) ? 1 : -1);
+  spots[11] = (long long int)c->nc[1] * ((d > 0) ? -1 : 1);
+  spots[12] = spots[10] + ((d > 0) ? 1 : -1);
+  spots[13] = spots[11] + ((d > 0) ? -1 : 1);
+  for (i = 0; i < 14; i++)
+  {
+    n = spots[i];
+    if ((n < nmin) || (n > nmax) || ((n == nmin) && (d == -1)))
+    {
+      continue;
+    }
+    if (kdiv_calculate_s(mags.M, mags.s, (int)n, d, W) != n / d)
+    {
+      c->spot++;
+    }
+  }
+  if (c->spot > 0)
+  {
+    c->ok = 0;
+  }
+  return ((c->ok == 1) ? KDIV_OK : KDIV_E_PROOF);
+}
+
+/*! Print a certificate line: 
+ *  d M a s p m e nc+ nc- spot result.
+ */
+int kdiv_cert_print(struct kdiv_buf *b, const struct kdiv_cert *c)
+{
+  if ((b == NULL) || (c == NULL))
+  {
+    return (KDIV_E_ARG);
+  }
+  return (kdiv_bprintf(b, 0, "%lld %u %d %d %d %llu %llu %llu %llu %d %s\n",
+    c->d, c->M, c->a, c->s, c->p, c->m, c->e, c->nc[0], c->nc[1], c->spot,
+    (c->ok == 1) ? "proven" : "FAILED"));
+}
+
+/*!
+   NOTES on modular multiplication by a constant modulus m.
+6) Barrett reduction of x = a*b (a, b < 2^32), with R = floor(2^64/m)
+  mul   x, a, b             // 64-bit product
+  mulhu q, x, R             // 64x64 -> high 64 bits; q is floor(x/m) or one less
+  mul   t, q, m
+  sub   r, x, t
+  sub   r, r, m             // only if r >= m
+
+7) Montgomery reduction (REDC) of T < m*2^32 for odd m, with
+   m' = -m^-1 mod 2^32, producing T*2^-32 mod m
+  mul   u, T, m'            // low 32 bits
+  mul   t, u, m             // 64-bit product
+  add   t, t, T             // 65-bit sum, keeping the carry
+  shrxi t, t, 32
+  sub   t, t, m             // only if t >= m
+*/
+
+/*! Calculate the constants of the modular multiplication kernels for the
+ *  modulus m (2 <= m <= 2^W-1, W <= 32).
+ */
+int kdiv_kmod(struct kmod *k, unsigned int m, unsigned int W)
+{
+  unsigned int inv;
+  int i;
+
+  if (k == NULL)
+  {
+    return (KDIV_E_ARG);
+  }
+  if (m == 0)
+  {
+    return (KDIV_E_DIVZERO);
+  }
+  if ((W < 2) || (W > 32))
+  {
+    return (KDIV_E_WIDTH);
+  }
+  if ((m < 2) || ((unsigned long long int)m > kdiv_ipowul(2, W) - 1))
+  {
+    return (KDIV_E_RANGE);
+  }
+  memset(k, 0, sizeof(*k));
+  k->m = m;
+  // floor(2^64/m), computed from 2^64-1 which is one less for powers-of-2.
+  k->R = ~0ULL / m + ((~0ULL % m) == m - 1);
+  k->r1 = (unsigned int)((1ULL << 32) % m);
+  k->r2 = (unsigned int)(((unsigned long long int)k->r1 * k->r1) % m);
+  if ((m & 1) == 1)
+  {
+    // Newton iteration for m^-1 mod 2^32; each step doubles the correct
+    // low-order bits (m is its own inverse mod 2^3).
+    inv = m;
+    for (i = 0; i < 4; i++)
+    {
+      inv = inv * (2 - m * inv);
+    }
+    k->minv = -inv;
+    k->mont = 1;
+  }
+  return (KDIV_OK);
+}
+
+/*! Compute (a * b) mod m by Barrett reduction according to NOTES 6).
+ */
+unsigned int kdiv_calculate_mulmod_barrett(const struct kmod *k, unsigned int a, unsigned int b)
+{
+  unsigned long long int x, q, r;
+
+  x = (unsigned long long int)a * b;
+  q = u128_mul(x, k->R).hi;
+  r = x - q * k->m;
+  if (r >= k->m)
+  {
+    r = r - k->m;
+  }
+  return ((unsigned int)r);
+}
+
+/*! Compute b^e mod m by square-and-multiply over Barrett reductions.
+ */
+unsigned int kdiv_calculate_powmod_barrett(const struct kmod *k, unsigned int b, unsigned int e)
+{
+  unsigned int r = 1;
+
+  while (e != 0)
+  {
+    if ((e & 1) != 0)
+    {
+      r = kdiv_calculate_mulmod_barrett(k, r, b);
+    }
+    b = kdiv_calculate_mulmod_barrett(k, b, b);
+    e = e >> 1;
+  }
+  return (r);
+}
+
+/*! Compute T * 2^-32 mod m by Montgomery reduction according to NOTES 7);
+ *  requires odd m and T < m*2^32.
+ */
+unsigned int kdiv_calculate_redc(const struct kmod *k, unsigned long long int T)
+{
+  unsigned long long int s, t;
+  unsigned int u;
+
+  u = (unsigned int)T * k->minv;
+  s = T + (unsigned long long int)u * k->m;
+  t = (s >> 32) | ((unsigned long long int)(s < T) << 32);
+  if (t >= k->m)
+  {
+    t = t - k->m;
+  }
+  return ((unsigned int)t);
+}
+
+/*! Compute b^e mod m in Montgomery form (odd m only).
+ */
+unsigned int kdiv_calculate_powmod_mont(const struct kmod *k, unsigned int b, unsigned int e)
+{
+  unsigned int x, r;
+
+  x = kdiv_calculate_redc(k, (unsigned long long int)b * k->r2);
+  r = k->r1;
+  while (e != 0)
+  {
+    if ((e & 1) != 0)
+    {
+      r = kdiv_calculate_redc(k, (unsigned long long int)r * x);
+    }
+    x = kdiv_calculate_redc(k, (unsigned long long int)x * x);
+    e = e >> 1;
+  }
+  return (kdiv_calculate_redc(k, r));
+}
+
+/*! Emit the portable 64x64 -> high 64 bits multiplication used by the C
+ *  Barrett kernels (once per translation unit).
+ */
+static void emit_mulhi64_ansic(struct kdiv_buf *f)
+{
+  kdiv_bprintf(f, 0, "#ifndef KMOD_MULHI64\n");
+  kdiv_bprintf(f, 0, "#define KMOD_MULHI64\n");
+  kdiv_bprintf(f, 0, "static unsigned long long int kmod_mulhi64 (unsigned long long int x, unsigned long long int y)\n");
+  kdiv_bprintf(f, 0, "{\n");
+  kdiv_bprintf(f, 0, "#if defined(__SIZEOF_INT128__)\n");
+  kdiv_bprintf(f, 2, "return ((unsigned long long int)(__extension__ ((unsigned __int128)x * y) >> 64));\n");
+  kdiv_bprintf(f, 0, "#else\n");
+  kdiv_bprintf(f, 2, "unsigned long long int x0 = x & 0xFFFFFFFFULL, x1 = x >> 32;\n");
+  kdiv_bprintf(f, 2, "unsigned long long int y0 = y & 0xFFFFFFFFULL, y1 = y >> 32;\n");
+  kdiv_bprintf(f, 2, "unsigned long long int p01 = x0 * y1, p10 = x1 * y0, mid;\n");
+  kdiv_bprintf(f, 2, "mid = ((x0 * y0) >> 32) + (p01 & 0xFFFFFFFFULL) + (p10 & 0xFFFFFFFFULL);\n");
+  kdiv_bprintf(f, 2, "return (x1 * y1 + (p01 >> 32) + (p10 >> 32) + (mid >> 32));\n");
+  kdiv_bprintf(f, 0, "#endif\n");
+  kdiv_bprintf(f, 0, "}\n");
+  kdiv_bprintf(f, 0, "#endif\n");
+}
+
+/*! Emit the ANSI C Barrett kernels for the modulus of k: mulmod, powmod
+ *  and an array variant of mulmod.
+ */
+int kdiv_emit_kmod_barrett_ansic(struct kdiv_buf *f, const struct kmod *k, unsigned int W)
+{
+  unsigned int m = k->m;
+
+  emit_mulhi64_ansic(f);
+  // mulmod
+  kdiv_bprintf(f, 0, "unsigned int kmod_u%d_%u_mulmod (unsigned int a, unsigned int b)\n", W, m);
+  kdiv_bprintf(f, 0, "{\n");
+  kdiv_bprintf(f, 2, "unsigned long long int x, q, r, R=%lluULL;\n", k->R);
+  kdiv_bprintf(f, 2, "x = (unsigned long long int)a * b;\n");
+  kdiv_bprintf(f, 2, "q = kmod_mulhi64(x, R);\n");
+  kdiv_bprintf(f, 2, "r = x - q * %uU;\n", m);
+  kdiv_bprintf(f, 2, "if (r >= %uU)\n", m);
+  kdiv_bprintf(f, 4, "r = r - %uU;\n", m);
+  kdiv_bprintf(f, 2, "return ((unsigned int)r);\n");
+  kdiv_bprintf(f, 0, "}\n");
+  // powmod
+  kdiv_bprintf(f, 0, "unsigned int kmod_u%d_%u_powmod (unsigned int b, unsigned int e)\n", W, m);
+  kdiv_bprintf(f, 0, "{\n");
+  kdiv_bprintf(f, 2, "unsigned int r = 1;\n");
+  kdiv_bprintf(f, 2, "while (e != 0)\n");
+  kdiv_bprintf(f, 2, "{\n");
+  kdiv_bprintf(f, 4, "if (e & 1)\n");
+  kdiv_bprintf(f, 6, "r = kmod_u%d_%u_mulmod(r, b);\n", W, m);
+  kdiv_bprintf(f, 4, "b = kmod_u%d_%u_mulmod(b, b);\n", W, m);
+  kdiv_bprintf(f, 4, "e = e >> 1;\n");
+  kdiv_bprintf(f, 2, "}\n");
+  kdiv_bprintf(f, 2, "return (r);\n");
+  kdiv_bprintf(f, 0, "}\n");
+  // batched mulmod
+  kdiv_bprintf(f, 0, "void kmod_u%d_%u_mulmod_array (const unsigned int *a, const unsigned int *b, unsigned int *r, unsigned long int n)\n", W, m);
+  kdiv_bprintf(f, 0, "{\n");
+  kdiv_bprintf(f, 2, "unsigned long int i;\n");
+  kdiv_bprintf(f, 2, "for (i = 0; i < n; i++)\n");
+  kdiv_bprintf(f, 4, "r[i] = kmod_u%d_%u_mulmod(a[i], b[i]);\n", W, m);
+  return (kdiv_bprintf(f, 0, "}\n"));
+}
+
+/*! Emit the ANSI C Montgomery kernels for the (odd) modulus of k: redc,
+ *  conversions into and out of Montgomery form, montmul, montpow (taking
+ *  and returning ordinary residues) and an array variant of montmul.
+ */
+int kdiv_emit_kmod_mont_ansic(struct kdiv_buf *f, const struct kmod *k, unsigned int W)
+{
+  unsigned int m = k->m;
+
+  if (k->mont == 0)
+  {
+    return (KDIV_E_UNSUPPORTED);
+  }
+  // redc
+  kdiv_bprintf(f, 0, "unsigned int kmod_u%d_%u_redc (unsigned long long int T)\n", W, m);
+  kdiv_bprintf(f, 0, "{\n");
+  kdiv_bprintf(f, 2, "unsigned long long int s, t;\n");
+  kdiv_bprintf(f, 2, "unsigned int u;\n");
+  kdiv_bprintf(f, 2, "u = (unsigned int)T * %uU;\n", k->minv);
+  kdiv_bprintf(f, 2, "s = T + (unsigned long long int)u * %uU;\n", m);
+  kdiv_bprintf(f, 2, "t = (s >> 32) | ((unsigned long long int)(s < T) << 32);\n");
+  kdiv_bprintf(f, 2, "if (t >= %uU)\n", m);
+  kdiv_bprintf(f, 4, "t = t - %uU;\n", m);
+  kdiv_bprintf(f, 2, "return ((unsigned int)t);\n");
+  kdiv_bprintf(f, 0, "}\n");
+  // conversions
+  kdiv_bprintf(f, 0, "unsigned int kmod_u%d_%u_tomont (unsigned int a)\n", W, m);
+  kdiv_bprintf(f, 0, "{\n");
+  kdiv_bprintf(f, 2, "return (kmod_u%d_%u_redc((unsigned long long int)a * %uU));\n", W, m, k->r2);
+  kdiv_bprintf(f, 0, "}\n");
+  kdiv_bprintf(f, 0, "unsigned int kmod_u%d_%u_frommont (unsigned int x)\n", W, m);
+  kdiv_bprintf(f, 0, "{\n");
+  kdiv_bprintf(f, 2, "return (kmod_u%d_%u_redc(x));\n", W, m);
+  kdiv_bprintf(f, 0, "}\n");
+  // montmul
+  kdiv_bprintf(f, 0, "unsigned int kmod_u%d_%u_montmul (unsigned int x, unsigned int y)\n", W, m);
+  kdiv_bprintf(f, 0, "{\n");
+  kdiv_bprintf(f, 2, "return (kmod_u%d_%u_redc((unsigned long long int)x * y));\n", W, m);
+  kdiv_bprintf(f, 0, "}\n");
+  // montpow
+  kdiv_bprintf(f, 0, "unsigned int kmod_u%d_%u_montpow (unsigned int b, unsigned int e)\n", W, m);
+  kdiv_bprintf(f, 0, "{\n");
+  kdiv_bprintf(f, 2, "unsigned int x, r = %uU;\n", k->r1);
+  kdiv_bprintf(f, 2, "x = kmod_u%d_%u_tomont(b);\n", W, m);
+  kdiv_bprintf(f, 2, "while (e != 0)\n");
+  kdiv_bprintf(f, 2, "{\n");
+  kdiv_bprintf(f, 4, "if (e & 1)\n");
+  kdiv_bprintf(f, 6, "r = kmod_u%d_%u_montmul(r, x);\n", W, m);
+  kdiv_bprintf(f, 4, "x = kmod_u%d_%u_montmul(x, x);\n", W, m);
+  kdiv_bprintf(f, 4, "e = e >> 1;\n");
+  kdiv_bprintf(f, 2, "}\n");
+  kdiv_bprintf(f, 2, "return (kmod_u%d_%u_frommont(r));\n", W, m);
+  kdiv_bprintf(f, 0, "}\n");
+  // batched montmul
+  kdiv_bprintf(f, 0, "void kmod_u%d_%u_montmul_array (const unsigned int *x, const unsigned int *y, unsigned int *r, unsigned long int n)\n", W, m);
+  kdiv_bprintf(f, 0, "{\n");
+  kdiv_bprintf(f, 2, "unsigned long int i;\n");
+  kdiv_bprintf(f, 2, "for (i = 0; i < n; i++)\n");
+  kdiv_bprintf(f, 4, "r[i] = kmod_u%d_%u_montmul(x[i], y[i]);\n", W, m);
+  return (kdiv_bprintf(f, 0, "}\n"));
+}
+
+/*! Emit the NAC sequence of NOTES 6) reducing the u64 variable x into the
+ *  u32 variable dst. *lbl is the next free state label.
+ */
+static void emit_barrett_nac_seq(struct kdiv_buf *f, const char *dst, int *lbl)
+{
+  int done = (*lbl)++, fix = (*lbl)++;
+
+  kdiv_bprintf(f, 2, "t <= mul x, R;\n");
+  kdiv_bprintf(f, 2, "t <= shr t, 64;\n");
+  kdiv_bprintf(f, 2, "q <= trunc t;\n");
+  kdiv_bprintf(f, 2, "v <= mul q, m;\n");
+  kdiv_bprintf(f, 2, "v <= sub x, v;\n");
+  kdiv_bprintf(f, 2, "S_%d, S_%d <= jmplt v, m;\n", done, fix);
+  kdiv_bprintf(f, 0, "S_%d:\n", fix);
+  kdiv_bprintf(f, 2, "v <= sub v, m;\n");
+  kdiv_bprintf(f, 2, "S_%d <= jmpun;\n", done);
+  kdiv_bprintf(f, 0, "S_%d:\n", done);
+  kdiv_bprintf(f, 2, "%s <= trunc v;\n", dst);
+}
+
+/*! Emit the NAC sequence of NOTES 7) reducing the u64 variable x into the
+ *  u32 variable dst. *lbl is the next free state label.
+ */
+static void emit_redc_nac_seq(struct kdiv_buf *f, const char *dst, int *lbl)
+{
+  int done = (*lbl)++, fix = (*lbl)++;
+
+  kdiv_bprintf(f, 2, "u <= trunc x;\n");
+  kdiv_bprintf(f, 2, "u <= mul u, mi;\n");
+  kdiv_bprintf(f, 2, "v <= mul u, m;\n");
+  kdiv_bprintf(f, 2, "t <= zxt v;\n");
+  kdiv_bprintf(f, 2, "w <= zxt x;\n");
+  kdiv_bprintf(f, 2, "t <= add t, w;\n");
+  kdiv_bprintf(f, 2, "t <= shr t, 32;\n");
+  kdiv_bprintf(f, 2, "v <= trunc t;\n");
+  kdiv_bprintf(f, 2, "S_%d, S_%d <= jmplt v, m;\n", done, fix);
+  kdiv_bprintf(f, 0, "S_%d:\n", fix);
+  kdiv_bprintf(f, 2, "v <= sub v, m;\n");
+  kdiv_bprintf(f, 2, "S_%d <= jmpun;\n", done);
+  kdiv_bprintf(f, 0, "S_%d:\n", done);
+  kdiv_bprintf(f, 2, "%s <= trunc v;\n", dst);
+}
+
+/*! Emit a NAC square-and-multiply loop over the exponent e, with r and b
+ *  the accumulator and base; seq emits a reduction of x into its argument.
+ */
+static void emit_powmod_nac_loop(struct kdiv_buf *f, int *lbl,
+  void (*seq)(struct kdiv_buf *, const char *, int *))
+{
+  int test = (*lbl)++, body = (*lbl)++, mul = (*lbl)++, sqr = (*lbl)++;
+  int done = (*lbl)++;
+
+  kdiv_bprintf(f, 2, "S_%d <= jmpun;\n", test);
+  kdiv_bprintf(f, 0, "S_%d:\n", test);
+  kdiv_bprintf(f, 2, "S_%d, S_%d <= jmpne e, 0;\n", body, done);
+  kdiv_bprintf(f, 0, "S_%d:\n", body);
+  kdiv_bprintf(f, 2, "c <= and e, 1;\n");
+  kdiv_bprintf(f, 2, "S_%d, S_%d <= jmpne c, 0;\n", mul, sqr);
+  kdiv_bprintf(f, 0, "S_%d:\n", mul);
+  kdiv_bprintf(f, 2, "x <= mul r, b;\n");
+  seq(f, "r", lbl);
+  kdiv_bprintf(f, 2, "S_%d <= jmpun;\n", sqr);
+  kdiv_bprintf(f, 0, "S_%d:\n", sqr);
+  kdiv_bprintf(f, 2, "x <= mul b, b;\n");
+  seq(f, "b", lbl);
+  kdiv_bprintf(f, 2, "e <= shr e, 1;\n");
+  kdiv_bprintf(f, 2, "S_%d <= jmpun;\n", test);
+  kdiv_bprintf(f, 0, "S_%d:\n", done);
+}
+
+/*! Emit the NAC Barrett kernels (mulmod and powmod) for the modulus of k.
+ */
+int kdiv_emit_kmod_barrett_nac(struct kdiv_buf *f, const struct kmod *k, unsigned int W)
+{
+  int lbl = 2;
+
+  kdiv_bprintf(f, 0, "procedure kmod_u%d_%u_mulmod (in u%d a, in u%d b, out u%d y)\n",
+    W, k->m, W, W, W);
+  kdiv_bprintf(f, 0, "{\n");
+  kdiv_bprintf(f, 2, "localvar u32 r;\n");
+  kdiv_bprintf(f, 2, "localvar u64 x, q, v, R, m;\n");
+  kdiv_bprintf(f, 2, "localvar u128 t;\n");
+  kdiv_bprintf(f, 0, "S_1:\n");
+  kdiv_bprintf(f, 2, "R <= ldc %llu;\n", k->R);
+  kdiv_bprintf(f, 2, "m <= ldc %u;\n", k->m);
+  kdiv_bprintf(f, 2, "x <= mul a, b;\n");
+  emit_barrett_nac_seq(f, "r", &lbl);
+  kdiv_bprintf(f, 2, "y <= mov r;\n");
+  kdiv_bprintf(f, 0, "}\n");
+
+  lbl = 2;
+  kdiv_bprintf(f, 0, "procedure kmod_u%d_%u_powmod (in u%d b0, in u%d e0, out u%d y)\n",
+    W, k->m, W, W, W);
+  kdiv_bprintf(f, 0, "{\n");
+  kdiv_bprintf(f, 2, "localvar u32 r, b, e, c;\n");
+  kdiv_bprintf(f, 2, "localvar u64 x, q, v, R, m;\n");
+  kdiv_bprintf(f, 2, "localvar u128 t;\n");
+  kdiv_bprintf(f, 0, "S_1:\n");
+  kdiv_bprintf(f, 2, "R <= ldc %llu;\n", k->R);
+  kdiv_bprintf(f, 2, "m <= ldc %u;\n", k->m);
+  kdiv_bprintf(f, 2, "r <= ldc 1;\n");
+  kdiv_bprintf(f, 2, "b <= mov b0;\n");
+  kdiv_bprintf(f, 2, "e <= mov e0;\n");
+  emit_powmod_nac_loop(f, &lbl, emit_barrett_nac_seq);
+  kdiv_bprintf(f, 2, "y <= mov r;\n");
+  return (kdiv_bprintf(f, 0, "}\n"));
+}
+
+/*! Emit the NAC Montgomery kernels (montmul on Montgomery residues and
+ *  montpow on ordinary residues) for the (odd) modulus of k.
+ */
+int kdiv_emit_kmod_mont_nac(struct kdiv_buf *f, const struct kmod *k, unsigned int W)
+{
+  int lbl = 2;
+
+  if (k->mont == 0)
+  {
+    return (KDIV_E_UNSUPPORTED);
+  }
+  kdiv_bprintf(f, 0, "procedure kmod_u%d_%u_montmul (in u%d a, in u%d b, out u%d y)\n",
+    W, k->m, W, W, W);
+  kdiv_bprintf(f, 0, "{\n");
+  kdiv_bprintf(f, 2, "localvar u32 r, u, mi;\n");
+  kdiv_bprintf(f, 2, "localvar u64 x, v, m;\n");
+  kdiv_bprintf(f, 2, "localvar u128 t, w;\n");
+  kdiv_bprintf(f, 0, "S_1:\n");
+  kdiv_bprintf(f, 2, "mi <= ldc %u;\n", k->minv);
+  kdiv_bprintf(f, 2, "m <= ldc %u;\n", k->m);
+  kdiv_bprintf(f, 2, "x <= mul a, b;\n");
+  emit_redc_nac_seq(f, "r", &lbl);
+  kdiv_bprintf(f, 2, "y <= mov r;\n");
+  kdiv_bprintf(f, 0, "}\n");
+
+  lbl = 2;
+  kdiv_bprintf(f, 0, "procedure kmod_u%d_%u_montpow (in u%d b0, in u%d e0, out u%d y)\n",
+    W, k->m, W, W, W);
+  kdiv_bprintf(f, 0, "{\n");
+  kdiv_bprintf(f, 2, "localvar u32 r, b, e, c, u, mi, r2;\n");
+  kdiv_bprintf(f, 2, "localvar u64 x, v, m;\n");
+  kdiv_bprintf(f, 2, "localvar u128 t, w;\n");
+  kdiv_bprintf(f, 0, "S_1:\n");
+  kdiv_bprintf(f, 2, "mi <= ldc %u;\n", k->minv);
+  kdiv_bprintf(f, 2, "m <= ldc %u;\n", k->m);
+  kdiv_bprintf(f, 2, "r2 <= ldc %u;\n", k->r2);
+  kdiv_bprintf(f, 2, "r <= ldc %u;\n", k->r1);
+  kdiv_bprintf(f, 2, "e <= mov e0;\n");
+  kdiv_bprintf(f, 2, "x <= mul b0, r2;\n");
+  emit_redc_nac_seq(f, "b", &lbl);
+  emit_powmod_nac_loop(f, &lbl, emit_redc_nac_seq);
+  kdiv_bprintf(f, 2, "x <= zxt r;\n");
+  emit_redc_nac_seq(f, "r", &lbl);
+  kdiv_bprintf(f, 2, "y <= mov r;\n");
+  return (kdiv_bprintf(f, 0, "}\n"));
+}
+
+/*! Emit a standalone C benchmark comparing the kernels of k (in the file
+ *  kname) against the naive % of the 64-bit product by a runtime modulus.
+ */
+int kdiv_emit_kmod_bench_ansic(struct kdiv_buf *f, const struct kmod *k, unsigned int W, const char *kname)
+{
+  unsigned int m = k->m;
+
+  kdiv_bprintf(f, 0, "#include <stdio.h>\n");
+  kdiv_bprintf(f, 0, "#include <time.h>\n");
+  kdiv_bprintf(f, 0, "#include \"%s\"\n", kname);
+  kdiv_bprintf(f, 0, "#define N    4096\n");
+  kdiv_bprintf(f, 0, "#define REPS 4000\n");
+  kdiv_bprintf(f, 0, "static unsigned int a[N], b[N], r0[N], r1[N], r2[N];\n");
+  kdiv_bprintf(f, 0, "volatile unsigned int modulus = %uU;\n", m);
+  kdiv_bprintf(f, 0, "int main(void)\n");
+  kdiv_bprintf(f, 0, "{\n");
+  kdiv_bprintf(f, 2, "unsigned int i, j, x = 12345, md = modulus, errors = 0, acc[3] = {0, 0, 0};\n");
+  kdiv_bprintf(f, 2, "clock_t c0, c1, c2, c3, c4, c5, c6;\n");
+  kdiv_bprintf(f, 2, "for (i = 0; i < N; i++)\n");
+  kdiv_bprintf(f, 2, "{\n");
+  kdiv_bprintf(f, 4, "x = x * 1664525U + 1013904223U;\n");
+  kdiv_bprintf(f, 4, "a[i] = x %% md;\n");
+  kdiv_bprintf(f, 4, "x = x * 1664525U + 1013904223U;\n");
+  kdiv_bprintf(f, 4, "b[i] = x %% md;\n");
+  kdiv_bprintf(f, 2, "}\n");
+  kdiv_bprintf(f, 2, "c0 = clock();\n");
+  kdiv_bprintf(f, 2, "for (j = 0; j < REPS; j++)\n");
+  kdiv_bprintf(f, 4, "for (i = 0; i < N; i++)\n");
+  kdiv_bprintf(f, 6, "r0[i] = (unsigned int)(((unsigned long long int)a[i] * b[(i + j) %% N]) %% md);\n");
+  kdiv_bprintf(f, 2, "c1 = clock();\n");
+  kdiv_bprintf(f, 2, "for (j = 0; j < REPS; j++)\n");
+  kdiv_bprintf(f, 4, "for (i = 0; i < N; i++)\n");
+  kdiv_bprintf(f, 6, "r1[i] = kmod_u%d_%u_mulmod(a[i], b[(i + j) %% N]);\n", W, m);
+  kdiv_bprintf(f, 2, "c2 = clock();\n");
+  if (k->mont == 1)
+  {
+    kdiv_bprintf(f, 2, "for (i = 0; i < N; i++)\n");
+    kdiv_bprintf(f, 2, "{\n");
+    kdiv_bprintf(f, 4, "a[i] = kmod_u%d_%u_tomont(a[i]);\n", W, m);
+    kdiv_bprintf(f, 4, "b[i] = kmod_u%d_%u_tomont(b[i]);\n", W, m);
+    kdiv_bprintf(f, 2, "}\n");
+    kdiv_bprintf(f, 2, "c2 = clock();\n");
+    kdiv_bprintf(f, 2, "for (j = 0; j < REPS; j++)\n");
+    kdiv_bprintf(f, 4, "for (i = 0; i < N; i++)\n");
+    kdiv_bprintf(f, 6, "r2[i] = kmod_u%d_%u_montmul(a[i], b[(i + j) %% N]);\n", W, m);
+    kdiv_bprintf(f, 2, "for (i = 0; i < N; i++)\n");
+    kdiv_bprintf(f, 4, "r2[i] = kmod_u%d_%u_frommont(r2[i]);\n", W, m);
+  }
+  else
+  {
+    kdiv_bprintf(f, 2, "for (i = 0; i < N; i++)\n");
+    kdiv_bprintf(f, 4, "r2[i] = r0[i];\n");
+  }
+  kdiv_bprintf(f, 2, "c3 = clock();\n");
+  kdiv_bprintf(f, 2, "for (i = 0; i < N; i++)\n");
+  kdiv_bprintf(f, 4, "errors += (r0[i] != r1[i]) + (r0[i] != r2[i]);\n");
+  // powmod
+  kdiv_bprintf(f, 2, "for (i = 0; i < N; i++)\n");
+  kdiv_bprintf(f, 2, "{\n");
+  kdiv_bprintf(f, 4, "unsigned long long int p = 1, q = i + 2;\n");
+  kdiv_bprintf(f, 4, "for (x = 0xDEADBEEFU ^ i; x != 0; x >>= 1, q = q * q %% md)\n");
+  kdiv_bprintf(f, 6, "if (x & 1) p = p * q %% md;\n");
+  kdiv_bprintf(f, 4, "acc[0] += (unsigned int)p;\n");
+  kdiv_bprintf(f, 2, "}\n");
+  kdiv_bprintf(f, 2, "c4 = clock();\n");
+  kdiv_bprintf(f, 2, "for (i = 0; i < N; i++)\n");
+  kdiv_bprintf(f, 4, "acc[1] += kmod_u%d_%u_powmod(i + 2, 0xDEADBEEFU ^ i);\n", W, m);
+  kdiv_bprintf(f, 2, "c5 = clock();\n");
+  if (k->mont == 1)
+  {
+    kdiv_bprintf(f, 2, "for (i = 0; i < N; i++)\n");
+    kdiv_bprintf(f, 4, "acc[2] += kmod_u%d_%u_montpow(i + 2, 0xDEADBEEFU ^ i);\n", W, m);
+  }
+  else
+  {
+    kdiv_bprintf(f, 2, "acc[2] = acc[0];\n");
+  }
+  kdiv_bprintf(f, 2, "c6 = clock();\n");
+  kdiv_bprintf(f, 2, "(void)c6;\n");
+  kdiv_bprintf(f, 2, "errors += (acc[0] != acc[1]) + (acc[0] != acc[2]);\n");
+  kdiv_bprintf(f, 2, "printf(\"modulus %u: %%u errors\\n\", errors);\n", m);
+  kdiv_bprintf(f, 2, "printf(\"mulmod  naive %%%%: %%8.3f ns/op\\n\", 1e9 * (c1 - c0) / CLOCKS_PER_SEC / ((double)N * REPS));\n");
+  kdiv_bprintf(f, 2, "printf(\"mulmod  Barrett: %%8.3f ns/op\\n\", 1e9 * (c2 - c1) / CLOCKS_PER_SEC / ((double)N * REPS));\n");
+  if (k->mont == 1)
+  {
+    kdiv_bprintf(f, 2, "printf(\"montmul Montgomery: %%5.3f ns/op\\n\", 1e9 * (c3 - c2) / CLOCKS_PER_SEC / ((double)N * REPS));\n");
+  }
+  kdiv_bprintf(f, 2, "printf(\"powmod  naive %%%%: %%8.1f ns/op\\n\", 1e9 * (c4 - c3) / CLOCKS_PER_SEC / N);\n");
+  kdiv_bprintf(f, 2, "printf(\"powmod  Barrett: %%8.1f ns/op\\n\", 1e9 * (c5 - c4) / CLOCKS_PER_SEC / N);\n");
+  if (k->mont == 1)
+  {
+    kdiv_bprintf(f, 2, "printf(\"montpow Montgomery: %%5.1f ns/op\\n\", 1e9 * (c6 - c5) / CLOCKS_PER_SEC / N);\n");
+  }
+  kdiv_bprintf(f, 2, "return (errors != 0);\n");
+  return (kdiv_bprintf(f, 0, "}\n"));
+}
+
+/*
+   NOTES on profile-guided dispatch for runtime divisors.
+8) The divisor d of a call is compared against the hot divisors of the 
+   profile, either in a chain ordered by decreasing frequency or in a switch 
+   (a balanced decision tree of at most log2ceil(nhot+1) comparisons); a hit
+   runs the routine of NOTES 1) to 5) and a miss falls back to div:
+  jmpeq d, d_1              // chain: one compare-and-branch per hot divisor
+  ...
+  div   q, n, d             // cold divisors
+*/
+
+/*! Calculate the expected cost per call of the dispatch routines for the 
+ *  hot divisors of a profile (in chain order) with cold calls to other 
+ *  divisors, in the unit-latency operations of struct kdiv_stats. Every 
+ *  comparison costs one operation and the hardware division divcost.
+ */
+int kdiv_dispatch_cost(struct kdiv_dcost *c, const struct kdiv_prof *hot, 
+  int nhot, unsigned long long int cold, unsigned int W, int is_signed, 
+  int divcost)
+{
+  struct kdiv_stats st;
+  unsigned long long int total;
+  double chain=0.0, ops=0.0;
+  int i, err, depth;
+
+  if ((c == NULL) || ((hot == NULL) && (nhot > 0)) || (nhot < 0))
+  {
+    return (KDIV_E_ARG);
+  }
+  memset(c, 0, sizeof(*c));
+  total = cold;
+  for (i = 0; i < nhot; i++)
+  {
+    total = total + hot[i].count;
+  }
+  if (total == 0)
+  {
+    return (KDIV_E_ARG);
+  }
+  for (i = 0; i < nhot; i++)
+  {
+    err = (is_signed == 0) ? kdiv_stats_u(&st, hot[i].d, W) 
+                           : kdiv_stats_s(&st, hot[i].d, W);
+    if (err != KDIV_OK)
+    {
+      return (err);
+    }
+    chain = chain + (double)hot[i].count * (i + 1);
+    ops   = ops + (double)hot[i].count * st.ops;
+    c->hit = c->hit + (double)hot[i].count;
+  }
+  depth = log2ceil(nhot + 1);
+  c->chain = (chain + ops + (double)cold * (nhot + divcost)) / total;
+  c->table = ((double)total * depth + ops + (double)cold * divcost) / total;
+  c->div   = divcost;
+  c->hit   = c->hit / total;
+  c->use_table = (c->table < c->chain);
+  return (KDIV_OK);
+}
+
+/*! Emit the ANSI C dispatch routine kdiv_<u|s><W>_dispatch (n, d) for the 
+ *  hot divisors of a profile according to NOTES 8): the routines of the hot
+ *  divisors as static functions, followed by a chain of comparisons in the
+ *  given order or, with table = 1, a switch. Other divisors use n / d.
+ */
+int kdiv_emit_dispatch_ansic(struct kdiv_buf *f, const struct kdiv_prof *hot, 
+  int nhot, unsigned int W, int is_signed, int table)
+{
+  struct kdiv_spec spec;
+  const char *type = (is_signed == 0) ? "unsigned" : "signed";
+  char ch = (is_signed == 0) ? 'u' : 's';
+  char name[64];
+  struct kdiv_buf nb;
+  int i, err;
+
+  if ((f == NULL) || ((hot == NULL) && (nhot > 0)) || (nhot < 0))
+  {
+    return (KDIV_E_ARG);
+  }
+  spec.width     = W;
+  spec.is_signed = is_signed;
+  spec.lang      = KDIV_LANG_ANSIC;
+  spec.mulwidth  = 0;
+  for (i = 0; i < nhot; i++)
+  {
+    spec.divisor = hot[i].d;
+    kdiv_bprintf(f, 0, "static ");
+    err = kdiv_generate(f, &spec);
+    if ((err != KDIV_OK) && (err != KDIV_E_NOSPACE))
+    {
+      return (err);
+    }
+  }
+  kdiv_bprintf(f, 0, "%s int kdiv_%c%d_dispatch (%s int n, %s int d)\n", 
+    type, ch, W, type, type);
+  kdiv_bprintf(f, 0, "{\n");
+  if (table == 1)
+  {
+    kdiv_bprintf(f, 2, "switch (d)\n");
+    kdiv_bprintf(f, 2, "{\n");
+  }
+  for (i = 0; i < nhot; i++)
+  {
+    spec.divisor = hot[i].d;
+    kdiv_buf_init(&nb, name, sizeof(name));
+    kdiv_routine_name(&nb, &spec);
+    if (table == 1)
+    {
+      kdiv_bprintf(f, 4, "case %d: return (%s(n));\n", hot[i].d, name);
+    }
+    else
+    {
+      kdiv_bprintf(f, 2, "if (d == %d)\n", hot[i].d);
+      kdiv_bprintf(f, 4, "return (%s(n));\n", name);
+    }
+  }
+  if (table == 1)
+  {
+    kdiv_bprintf(f, 4, "default: return (n / d);\n");
+    kdiv_bprintf(f, 2, "}\n");
+  }
+  else
+  {
+    kdiv_bprintf(f, 2, "return (n / d);\n");
+  }
+  return (kdiv_bprintf(f, 0, "}\n"));
+}
+
+/*!
+   NOTES on multiword decomposition of the high multiply.
+9) For targets with only an mw x mw -> 2mw multiplier (W = k*mw), M and n
+   are split into mw-bit limbs M_i and n_j and the high word of M*n is 
+   accumulated column by column from the partial products M_i*n_j (column 
+   i+j for the low half, i+j+1 for the high half). Partial products with 
+   M_i = 0 are skipped, and for unsigned division the columns below cd are
+   dropped and replaced by the carry cin into column cd, as long as the
+   bounds of struct kdiv_cert still hold for the perturbed product. Signed
+   division uses the unsigned product of the W-bit patterns and subtracts 
+   n (for M < 0) and M (for n < 0) from its high word.
+  li    ac, cin
+  mul   pp, M_i, n_j        // for every column c >= cd and i+j = c
+  add   ac, ac, lo(pp)
+  add   hc, hc, hi(pp)
+  ...                       // digit c-k of the high word is lo(ac) for c >= k
+  shri  ac, ac, mw
+  add   ac, ac, hc          // carry into column c+1
+*/
+
+/*! Calculate the high word of Ml * n, less the dropped partial products 
+ *  and plus the carry cin, according to NOTES 9).
+ */
+static unsigned int mulw_mulhi(const struct kdiv_mulw *w, unsigned int n)
+{
+  unsigned long int l[4], pp, ac, hc, mask;
+  unsigned int hi=0;
+  int i, j, col;
+  
+  mask = (1UL << w->mw) - 1;
+  for (j = 0; j < w->k; j++)
+  {
+    l[j] = (n >> (j * w->mw)) & mask;
+  }
+  ac = w->cin;
+  hc = 0;
+  for (col = w->cd; col < 2*w->k; col++)
+  {
+    for (i = 0; i < w->k; i++)
+    {
+      j = col - i;
+      if ((j >= 0) && (j < w->k) && (w->Ml[i] != 0))
+      {
+        pp = (unsigned long int)w->Ml[i] * l[j];
+        ac = ac + (pp & mask);
+        hc = hc + (pp >> w->mw);
+      }
+    }
+    if (col >= w->k)
+    {
+      hi = hi | ((unsigned int)(ac & mask) << ((col - w->k) * w->mw));
+    }
+    ac = (ac >> w->mw) + hc;
+    hc = 0;
+  }
+  return (hi);
+}
+
+/*! Fill the limbs of M and the common fields of a decomposition.
+ */
+static void mulw_init(struct kdiv_mulw *w, unsigned int W, unsigned int mw)
+{
+  int i, j;
+  
+  w->W  = W;
+  w->mw = mw;
+  w->k  = W / mw;
+  for (i = 0; i < w->k; i++)
+  {
+    w->Ml[i] = (w->M >> (i * mw)) & ((1u << mw) - 1);
+  }
+  w->nprod = 0;
+  for (i = 0; i < w->k; i++)
+  {
+    for (j = 0; j < w->k; j++)
+    {
+      w->nprod += (w->Ml[i] != 0) && (i + j >= w->cd);
+    }
+  }
+}
+
+/*! Check the multiplier width mw for the bitwidth W: 8 <= mw < W, with W
+ *  a multiple of mw.
+ */
+static int mulw_check(unsigned int W, unsigned int mw)
+{
+  if ((mw < 8) || (mw >= W) || ((W % mw) != 0))
+  {
+    return (KDIV_E_MULWIDTH);
+  }
+  return (KDIV_OK);
+}
+
+/*! Decompose the high multiply of the unsigned division routine for d into
+ *  mw x mw -> 2mw partial products according to NOTES 9), dropping the 
+ *  most low-order columns whose largest contribution C (rounded up to the
+ *  carry cin) keeps q*e + m*r + C < 2^p for all dividends. The routines of
+ *  powers-of-2 need no multiply (nprod = 0).
+ */
+int kdiv_mulw_u(struct kdiv_mulw *w, unsigned int d, unsigned int W, unsigned int mw)
+{
+  struct kdiv_stats st;
+  struct mu magu;
+  struct u128 md, pw, e, smax, sc, lim, C;
+  unsigned long long int m, nmax, nc, dmax, cin;
+  int err, cd, i, j, shift;
+  
+  if (w == NULL)
+  {
+    return (KDIV_E_ARG);
+  }
+  err = kdiv_stats_u(&st, d, W);
+  if (err != KDIV_OK)
+  {
+    return (err);
+  }
+  err = mulw_check(W, mw);
+  if (err != KDIV_OK)
+  {
+    return (err);
+  }
+  memset(w, 0, sizeof(*w));
+  w->d = d;
+  if (st.pow2 == 1)
+  {
+    w->W  = W;
+    w->mw = mw;
+    w->s  = log2ceil(d);
+    return (KDIV_OK);
+  }
+  magu = kdiv_magicu(d, W);
+  w->M = magu.M;
+  w->a = magu.a;
+  w->s = magu.s;
+  
+  // Largest q*e + m*r over 0 <= n <= nmax, at nmax or at the largest n 
+  // with r = d-1; the routine is exact iff it stays below 2^p.
+  nmax = kdiv_ipowul(2, W) - 1;
+  m  = magu.M + ((magu.a != 0) ? kdiv_ipowul(2, W) : 0);
+  pw = u128_shl(1, W + magu.s);
+  md = u128_mul(m, d);
+  if ((u128_cmp(md, pw) < 0) || (u128_sub(md, pw).hi != 0))
+  {
+    mulw_init(w, W, mw);
+    return (KDIV_OK);
+  }
+  e = u128_sub(md, pw);
+  smax = u128_add(u128_mul(e.lo, nmax / d), u128_mul(m, nmax % d));
+  if (nmax + 1 >= d)
+  {
+    nc = nmax - (nmax + 1) % d;
+    sc = u128_add(u128_mul(e.lo, nc / d), u128_mul(m, d - 1));
+    if (u128_cmp(sc, smax) > 0)
+    {
+      smax = sc;
+    }
+  }
+  // The truncated product must also stay below 2^(2W).
+  lim = u128_sub(u128_shl(1, 2*W), u128_mul(magu.M, nmax));
+  
+  for (cd = W / mw; cd > 0; cd--)
+  {
+    dmax = 0;
+    for (i = 0; i < (int)(W / mw); i++)
+    {
+      for (j = 0; i + j < cd; j++)
+      {
+        dmax += (unsigned long long int)((magu.M >> (i * mw)) & ((1u << mw) - 1))
+              * ((1u << mw) - 1) << ((i + j) * mw);
+      }
+    }
+    shift = cd * mw;
+    cin = (dmax + (1ULL << shift) - 1) >> shift;
+    C = u128_shl(cin, shift);
+    if ((u128_cmp(u128_add(smax, C), pw) < 0) && (u128_cmp(C, lim) < 0))
+    {
+      break;
+    }
+  }
+  w->cd  = cd;
+  w->cin = (cd > 0) ? (unsigned int)cin : 0;
+  mulw_init(w, W, mw);
+  return (KDIV_OK);
+}
+
+/*! Decompose the high multiply of the signed division routine for d into
+ *  mw x mw -> 2mw partial products according to NOTES 9), keeping every 
+ *  partial product with M_i != 0.
+ */
+int kdiv_mulw_s(struct kdiv_mulw *w, int d, unsigned int W, unsigned int mw)
+{
+  struct kdiv_stats st;
+  struct ms mags;
+  int err;
+  
+  if (w == NULL)
+  {
+    return (KDIV_E_ARG);
+  }
+  err = kdiv_stats_s(&st, d, W);
+  if (err != KDIV_OK)
+  {
+    return (err);
+  }
+  err = mulw_check(W, mw);
+  if (err != KDIV_OK)
+  {
+    return (err);
+  }
+  memset(w, 0, sizeof(*w));
+  w->d = d;
+  w->is_signed = 1;
+  if (st.muls == 0)
+  {
+    w->W  = W;
+    w->mw = mw;
+    return (KDIV_OK);
+  }
+  mags = kdiv_magic(d, W);
+  w->M = (unsigned int)mags.M & (unsigned int)(kdiv_ipowul(2, W) - 1);
+  w->s = mags.s;
+  w->a = ((d > 0) && (mags.M < 0)) ? 1 : ((d < 0) && (mags.M > 0)) ? -1 : 0;
+  mulw_init(w, W, mw);
+  return (KDIV_OK);
+}
+
+/*! Perform an unsigned division by constant with the decomposed high 
+ *  multiply of w, as in the routines of kdiv_emit_u_mulw_*.
+ */
+unsigned int kdiv_calculate_u_mulw(const struct kdiv_mulw *w, unsigned int n)
+{
+  unsigned long long int t;
+  unsigned int q;
+  
+  if (w->nprod == 0)
+  {
+    return (kdiv_calculate_u(0, 0, w->s, n, (unsigned int)w->d, w->W));
+  }
+  q = mulw_mulhi(w, n);
+  if (w->a == 0)
+  {
+    q = q >> w->s;
+  }
+  else
+  {
+    t = (unsigned long long int)q + n;
+    q = t >> w->s;
+  }
+  return (q);
+}
+
+/*! Perform a signed division by constant with the decomposed high 
+ *  multiply of w, as in the routines of kdiv_emit_s_mulw_*.
+ */
+int kdiv_calculate_s_mulw(const struct kdiv_mulw *w, int n)
+{
+  unsigned int nu, hu, mask, c;
+  int q;
+  
+  if (w->nprod == 0)
+  {
+    return (kdiv_calculate_s(0, w->s, n, (int)w->d, w->W));
+  }
+  mask = (unsigned int)(kdiv_ipowul(2, w->W) - 1);
+  nu = (unsigned int)n & mask;
+  hu = mulw_mulhi(w, nu);
+  // mulhs from mulhu: subtract n if M < 0 and M if n < 0.
+  if (((w->M >> (w->W - 1)) & 1) != 0)
+  {
+    hu = hu - nu;
+  }
+  if (n < 0)
+  {
+    hu = hu - w->M;
+  }
+  hu = hu & mask;
+  q = (int)(((hu >> (w->W - 1)) & 1) ? (long long int)hu - (long long int)kdiv_ipowul(2, w->W) : hu);
+  if (w->a == 1)
+  {
+    q = q + n;
+  }
+  else if (w->a == -1)
+  {
+    q = q - n;
+  }
+  q = q >> w->s;
+  c = ((unsigned int)((w->d < 0) ? q : n) >> (w->W - 1)) & 1;
+  return (q + c);
+}
+
+/*!
+   NOTES on the division of multi-limb integers by a single-limb constant.
+10) The limbs of a (32-bit, least significant first) are divided from the 
+   most significant one down, each step dividing the two-limb value <r, u0>
+   by the normalized divisor dn = d << l with the reciprocal 
+   v = floor((2^64-1)/dn) - 2^32 (Moller-Granlund), where u0 is the next 
+   limb of a << l and r < dn the running remainder:
+  mul   p, v, r             // 64-bit product
+  add   p, p, <r, u0>       // 64-bit sum
+  add   q1, hi(p), 1
+  mul   t, q1, dn           // low 32 bits
+  sub   r, u0, t
+  ...                       // if r > lo(p): q1 = q1 - 1, r = r + dn
+  ...                       // if r >= dn (rare): q1 = q1 + 1, r = r - dn
+   The final remainder is r >> l.
+*/
+
+/*! Calculate the constants of the division of multi-limb integers by the 
+ *  single-limb constant d (d >= 1).
+ */
+int kdiv_kbig(struct kbig *k, unsigned int d)
+{
+  if (k == NULL)
+  {
+    return (KDIV_E_ARG);
+  }
+  if (d == 0)
+  {
+    return (KDIV_E_DIVZERO);
+  }
+  memset(k, 0, sizeof(*k));
+  k->d = d;
+  while (((d << k->l) & 0x80000000U) == 0)
+  {
+    k->l++;
+  }
+  k->dn = d << k->l;
+  k->v  = (unsigned int)(~0ULL / k->dn - 0x100000000ULL);
+  return (KDIV_OK);
+}
+
+/*! Divide the n-limb integer a by the constant of k according to NOTES 10)
+ *  and return the remainder. The quotient limbs are stored into q unless it
+ *  is NULL; q may be the same array as a.
+ */
+unsigned int kdiv_calculate_kbig_divrem(const struct kbig *k, unsigned int *q, 
+  const unsigned int *a, size_t n)
+{
+  unsigned long long int p;
+  unsigned int r, u0, q0, q1, m;
+  size_t i;
+  
+  if (n == 0)
+  {
+    return (0);
+  }
+  r = (k->l > 0) ? a[n-1] >> (32 - k->l) : 0;
+  for (i = n; i-- > 0; )
+  {
+    u0 = (k->l > 0) ? a[i] << k->l : a[i];
+    if ((k->l > 0) && (i > 0))
+    {
+      u0 = u0 | (a[i-1] >> (32 - k->l));
+    }
+    p  = (unsigned long long int)k->v * r + (((unsigned long long int)r << 32) | u0);
+    q1 = (unsigned int)(p >> 32) + 1;
+    q0 = (unsigned int)p;
+    u0 = u0 - q1 * k->dn;
+    m  = 0U - (unsigned int)(u0 > q0);
+    q1 = q1 + m;
+    u0 = u0 + (m & k->dn);
+    if (u0 >= k->dn)
+    {
+      q1 = q1 + 1;
+      u0 = u0 - k->dn;
+    }
+    if (q != NULL)
+    {
+      q[i] = q1;
+    }
+    r = u0;
+  }
+  return (r >> k->l);
+}
+
+/*! Emit one ANSI C limb-array routine of NOTES 10): divrem (storing the 
+ *  quotient limbs) or mod (remainder only).
+ */
+static void kdiv_emit_kbig_routine_ansic(struct kdiv_buf *f, const struct kbig *k, 
+  int store)
+{
+  int l = k->l;
+  
+  if (store == 1)
+  {
+    kdiv_bprintf(f, 0, "unsigned int kbig_u32_%u_divrem (unsigned int *q, const unsigned int *a, unsigned long int n)\n", k->d);
+  }
+  else
+  {
+    kdiv_bprintf(f, 0, "unsigned int kbig_u32_%u_mod (const unsigned int *a, unsigned long int n)\n", k->d);
+  }
+  kdiv_bprintf(f, 0, "{\n");
+  kdiv_bprintf(f, 2, "unsigned long long int p;\n");
+  kdiv_bprintf(f, 2, "unsigned int r, u0, q0, q1, m;\n");
+  kdiv_bprintf(f, 2, "unsigned long int i;\n");
+  kdiv_bprintf(f, 2, "if (n == 0)\n");
+  kdiv_bprintf(f, 4, "return (0);\n");
+  if (l > 0)
+  {
+    kdiv_bprintf(f, 2, "r = a[n-1] >> %d;\n", 32 - l);
+  }
+  else
+  {
+    kdiv_bprintf(f, 2, "r = 0;\n");
+  }
+  kdiv_bprintf(f, 2, "for (i = n; i-- > 0; )\n");
+  kdiv_bprintf(f, 2, "{\n");
+  if (l > 0)
+  {
+    kdiv_bprintf(f, 4, "u0 = a[i] << %d;\n", l);
+    kdiv_bprintf(f, 4, "if (i > 0)\n");
+    kdiv_bprintf(f, 6, "u0 = u0 | (a[i-1] >> %d);\n", 32 - l);
+  }
+  else
+  {
+    kdiv_bprintf(f, 4, "u0 = a[i];\n");
+  }
+  kdiv_bprintf(f, 4, "p = (unsigned long long int)%uU * r + (((unsigned long long int)r << 32) | u0);\n", k->v);
+  kdiv_bprintf(f, 4, "q1 = (unsigned int)(p >> 32) + 1;\n");
+  kdiv_bprintf(f, 4, "q0 = (unsigned int)p;\n");
+  kdiv_bprintf(f, 4, "u0 = u0 - q1 * %uU;\n", k->dn);
+  kdiv_bprintf(f, 4, "m = 0U - (unsigned int)(u0 > q0);\n");
+  kdiv_bprintf(f, 4, "q1 = q1 + m;\n");
+  kdiv_bprintf(f, 4, "u0 = u0 + (m & %uU);\n", k->dn);
+  kdiv_bprintf(f, 4, "if (u0 >= %uU)\n", k->dn);
+  kdiv_bprintf(f, 4, "{\n");
+  kdiv_bprintf(f, 6, "q1 = q1 + 1;\n");
+  kdiv_bprintf(f, 6, "u0 = u0 - %uU;\n", k->dn);
+  kdiv_bprintf(f, 4, "}\n");
+  if (store == 1)
+  {
+    kdiv_bprintf(f, 4, "q[i] = q1;\n");
+  }
+  else
+  {
+    kdiv_bprintf(f, 4, "(void)q1;\n");
+  }
+  kdiv_bprintf(f, 4, "r = u0;\n");
+  kdiv_bprintf(f, 2, "}\n");
+  if (l > 0)
+  {
+    kdiv_bprintf(f, 2, "return (r >> %d);\n", l);
+  }
+  else
+  {
+    kdiv_bprintf(f, 2, "return (r);\n");
+  }
+  kdiv_bprintf(f, 0, "}\n");
+}
+
+/*! Emit the ANSI C limb-array routines dividing by the constant of k: 
+ *  kbig_u32_<d>_divrem (quotient limbs and remainder) and kbig_u32_<d>_mod
+ *  (remainder only). Neither uses a hardware division.
+ */
+int kdiv_emit_kbig_ansic(struct kdiv_buf *f, const struct kbig *k)
+{
+  kdiv_emit_kbig_routine_ansic(f, k, 1);
+  kdiv_emit_kbig_routine_ansic(f, k, 0);
+  return (kdiv_buf_status(f));
+}
+
+/*! Emit a benchmark driver for the routines of k (included from kname): 
+ *  it checks them against schoolbook division with a hardware divide by a
+ *  runtime divisor and reports the throughput of both in limbs per cycle 
+ *  (on x86 with GCC or Clang; elsewhere in ns per limb only).
+ */
+int kdiv_emit_kbig_bench_ansic(struct kdiv_buf *f, const struct kbig *k, const char *kname)
+{
+  unsigned int d = k->d;
+  
+  kdiv_bprintf(f, 0, "#include <stdio.h>\n");
+  kdiv_bprintf(f, 0, "#include <time.h>\n");
+  kdiv_bprintf(f, 0, "#include \"%s\"\n", kname);
+  kdiv_bprintf(f, 0, "#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))\n");
+  kdiv_bprintf(f, 0, "#define CYCLES() __builtin_ia32_rdtsc()\n");
+  kdiv_bprintf(f, 0, "#else\n");
+  kdiv_bprintf(f, 0, "#define CYCLES() 0ULL\n");
+  kdiv_bprintf(f, 0, "#endif\n");
+  kdiv_bprintf(f, 0, "#define N    4096\n");
+  kdiv_bprintf(f, 0, "#define REPS 2000\n");
+  kdiv_bprintf(f, 0, "static unsigned int a[N], q0[N], q1[N];\n");
+  kdiv_bprintf(f, 0, "volatile unsigned int divisor = %uU;\n", d);
+  kdiv_bprintf(f, 0, "static unsigned int divrem_hw (unsigned int *q, const unsigned int *a, unsigned long int n, unsigned int d)\n");
+  kdiv_bprintf(f, 0, "{\n");
+  kdiv_bprintf(f, 2, "unsigned long long int t;\n");
+  kdiv_bprintf(f, 2, "unsigned int r = 0;\n");
+  kdiv_bprintf(f, 2, "unsigned long int i;\n");
+  kdiv_bprintf(f, 2, "for (i = n; i-- > 0; )\n");
+  kdiv_bprintf(f, 2, "{\n");
+  kdiv_bprintf(f, 4, "t = ((unsigned long long int)r << 32) | a[i];\n");
+  kdiv_bprintf(f, 4, "q[i] = (unsigned int)(t / d);\n");
+  kdiv_bprintf(f, 4, "r = (unsigned int)(t %% d);\n");
+  kdiv_bprintf(f, 2, "}\n");
+  kdiv_bprintf(f, 2, "return (r);\n");
+  kdiv_bprintf(f, 0, "}\n");
+  kdiv_bprintf(f, 0, "int main(void)\n");
+  kdiv_bprintf(f, 0, "{\n");
+  kdiv_bprintf(f, 2, "unsigned int i, j, n, x = 12345, d = divisor, errors = 0, r0 = 0, r1 = 0;\n");
+  kdiv_bprintf(f, 2, "unsigned long long int y0, y1, y2;\n");
+  kdiv_bprintf(f, 2, "clock_t c0, c1, c2;\n");
+  kdiv_bprintf(f, 2, "for (i = 0; i < N; i++)\n");
+  kdiv_bprintf(f, 2, "{\n");
+  kdiv_bprintf(f, 4, "x = x * 1664525U + 1013904223U;\n");
+  kdiv_bprintf(f, 4, "a[i] = x;\n");
+  kdiv_bprintf(f, 2, "}\n");
+  // Correctness over all prefixes of a (and of its complement) first.
+  kdiv_bprintf(f, 2, "for (n = 0; n <= 64; n++)\n");
+  kdiv_bprintf(f, 2, "{\n");
+  kdiv_bprintf(f, 4, "for (j = 0; j < 2; j++)\n");
+  kdiv_bprintf(f, 4, "{\n");
+  kdiv_bprintf(f, 6, "r0 = divrem_hw(q0, a, n, d);\n");
+  kdiv_bprintf(f, 6, "r1 = kbig_u32_%u_divrem(q1, a, n);\n", d);
+  kdiv_bprintf(f, 6, "errors += (r0 != r1) + (r0 != kbig_u32_%u_mod(a, n));\n", d);
+  kdiv_bprintf(f, 6, "for (i = 0; i < n; i++)\n");
+  kdiv_bprintf(f, 8, "errors += (q0[i] != q1[i]);\n");
+  kdiv_bprintf(f, 6, "for (i = 0; i < N; i++)\n");
+  kdiv_bprintf(f, 8, "a[i] = ~a[i];\n");
+  kdiv_bprintf(f, 4, "}\n");
+  kdiv_bprintf(f, 2, "}\n");
+  kdiv_bprintf(f, 2, "c0 = clock();\n");
+  kdiv_bprintf(f, 2, "y0 = CYCLES();\n");
+  kdiv_bprintf(f, 2, "for (j = 0; j < REPS; j++)\n");
+  kdiv_bprintf(f, 4, "r0 += divrem_hw(q0, a, N, d);\n");
+  kdiv_bprintf(f, 2, "c1 = clock();\n");
+  kdiv_bprintf(f, 2, "y1 = CYCLES();\n");
+  kdiv_bprintf(f, 2, "for (j = 0; j < REPS; j++)\n");
+  kdiv_bprintf(f, 4, "r1 += kbig_u32_%u_divrem(q1, a, N);\n", d);
+  kdiv_bprintf(f, 2, "c2 = clock();\n");
+  kdiv_bprintf(f, 2, "y2 = CYCLES();\n");
+  kdiv_bprintf(f, 2, "errors += (r0 != r1);\n");
+  kdiv_bprintf(f, 2, "for (i = 0; i < N; i++)\n");
+  kdiv_bprintf(f, 4, "errors += (q0[i] != q1[i]);\n");
+  kdiv_bprintf(f, 2, "printf(\"divisor %u: %%u errors\\n\", errors);\n", d);
+  kdiv_bprintf(f, 2, "printf(\"divrem  hardware div: %%8.3f ns/limb\", 1e9 * (c1 - c0) / CLOCKS_PER_SEC / ((double)N * REPS));\n");
+  kdiv_bprintf(f, 2, "if (y1 != y0)\n");
+  kdiv_bprintf(f, 4, "printf(\", %%6.3f limbs/cycle\", (double)N * REPS / (double)(y1 - y0));\n");
+  kdiv_bprintf(f, 2, "printf(\"\\n\");\n");
+  kdiv_bprintf(f, 2, "printf(\"divrem  reciprocal:   %%8.3f ns/limb\", 1e9 * (c2 - c1) / CLOCKS_PER_SEC / ((double)N * REPS));\n");
+  kdiv_bprintf(f, 2, "if (y2 != y1)\n");
+  kdiv_bprintf(f, 4, "printf(\", %%6.3f limbs/cycle\", (double)N * REPS / (double)(y2 - y1));\n");
+  kdiv_bprintf(f, 2, "printf(\"\\n\");\n");
+  kdiv_bprintf(f, 2, "return (errors != 0);\n");
+  return (kdiv_bprintf(f, 0, "}\n"));
+}
+
+/*!
+   NOTES on the floating-point reciprocal lowering.
+11) With c the reciprocal 1/|d| rounded up to a p-bit significand (p = 24 
+   for float, 53 for double) and |n| <= nmax <= 2^p, so that n converts 
+   exactly:
+  cvt   x, n                // int to float/double (exact)
+  fmul  x, x, c             // rounded to nearest
+  cvtt  q, x                // truncation towards zero
+   As c >= 1/|d| and rounding is monotonic, fl(n*c) >= q = floor(n/|d|) 
+   (q is representable). With delta = |d|*c - 1 and h(q) half the spacing 
+   of the floats just below q+1, the dividend n = q*|d| + |d| - 1 stays 
+   below q+1 iff c - (q+1)*delta > h(q); the left-hand side decreases and 
+   h(q) increases with q, so it suffices to check the largest q with a full
+   remainder range, and n = nmax itself when its quotient is above it. 
+   Negative dividends and divisors follow by symmetry.
+*/
+
+/*! Check the bounds of NOTES 11) for the reciprocal mc * 2^-S of d with a 
+ *  p-bit significand over the dividends 0..nmax. Returns 1 when they hold.
+ */
+static int fp_bound(unsigned long long int d, unsigned long long int nmax,
+  unsigned long long int mc, int S, int p)
+{
+  struct u128 lhs, rhs;
+  unsigned long long int X, q, qf;
+  int E;
+  
+  // 2^S * delta = d*mc - 2^S < d.
+  X = u128_sub(u128_mul(mc, d), u128_shl(1, S)).lo;
+  q = nmax / d;
+  // Scaled by 2^(S+2), h(q) = 2^(S+E-p+2) with E = floor(log2(q)) (-1 for 
+  // q = 0) and S >= p-1.
+  if (nmax + 1 >= d)
+  {
+    qf = (nmax + 1) / d - 1;
+    for (E = -1; (E < 63) && ((qf >> (E + 1)) != 0); E++)
+      ;
+    lhs = u128_shl(mc, 2);
+    rhs = u128_add(u128_mul(4 * (qf + 1), X), u128_shl(1, S + E - p + 2));
+    if (u128_cmp(lhs, rhs) <= 0)
+    {
+      return (0);
+    }
+    if (qf == q)
+    {
+      return (1);
+    }
+  }
+  for (E = -1; (E < 63) && ((q >> (E + 1)) != 0); E++)
+    ;
+  lhs = u128_mul(4 * nmax, mc);
+  rhs = u128_sub(u128_shl(4 * (q + 1), S), u128_shl(1, S + E - p + 2));
+  return (u128_cmp(lhs, rhs) < 0);
+}
+
+/*! Calculate the reciprocal of the floating-point lowering of NOTES 11) for
+ *  the divisor d over the dividends |n| <= nmax (0: the whole range of W), 
+ *  in float if that is proven exact and in double otherwise. Returns 
+ *  KDIV_E_PROOF (with fp->ok = 0) if neither is exact.
+ */
+int kdiv_fp(struct kdiv_fp *fp, int d, unsigned int W, int is_signed, 
+  unsigned long long int nmax)
+{
+  unsigned long long int ad, wmax, q, r;
+  int err, i, k, p;
+  
+  if (fp == NULL)
+  {
+    return (KDIV_E_ARG);
+  }
+  err = kdiv_check(d, W, is_signed);
+  if (err != KDIV_OK)
+  {
+    return (err);
+  }
+  wmax = (is_signed == 0) ? kdiv_ipowul(2, W) - 1 : kdiv_ipowul(2, W-1);
+  if (nmax == 0)
+  {
+    nmax = wmax;
+  }
+  if (nmax > wmax)
+  {
+    return (KDIV_E_RANGE);
+  }
+  memset(fp, 0, sizeof(*fp));
+  fp->d = d;
+  fp->W = W;
+  fp->is_signed = is_signed;
+  fp->nmax = nmax;
+  ad = (d > 0) ? (unsigned long long int)d : (unsigned long long int)(-(long long)d);
+  k  = log2ceil((unsigned int)ad);
+  for (fp->dbl = 0; fp->dbl <= 1; fp->dbl++)
+  {
+    p = (fp->dbl == 1) ? 53 : 24;
+    // 1/ad lies in [2^-k, 2^(1-k)): mc = ceil(2^S/ad) has p bits.
+    fp->S = k + p - 1;
+    q = (ad == 1);
+    r = 1 - q;
+    for (i = 0; i < fp->S; i++)
+    {
+      r = r << 1;
+      q = q << 1;
+      if (r >= ad)
+      {
+        q = q | 1;
+        r = r - ad;
+      }
+    }
+    fp->mc = q + (r != 0);
+    if ((nmax <= kdiv_ipowul(2, p)) && (fp_bound(ad, nmax, fp->mc, fp->S, p) == 1))
+    {
+      fp->ok = 1;
+      return (KDIV_OK);
+    }
+  }
+  fp->dbl = 1;
+  return (KDIV_E_PROOF);
+}
+
+/*! Calculate n / d by the floating-point lowering of fp (NOTES 11)), in the
+ *  precision of fp and the default rounding mode.
+ */
+long long kdiv_calculate_fp(const struct kdiv_fp *fp, long long n)
+{
+  double cd;
+  float cf;
+  int S;
+  
+  // Scaling by powers of 2 is exact.
+  cd = (double)fp->mc;
+  for (S = fp->S; S >= 32; S -= 32)
+  {
+    cd = cd / 4294967296.0;
+  }
+  cd = cd / (double)(1ULL << S);
+  cf = (float)cd;
+  if (fp->d < 0)
+  {
+    cd = -cd;
+    cf = -cf;
+  }
+  if (fp->dbl == 1)
+  {
+    return ((long long)((double)n * cd));
+  }
+  return ((long long)((float)n * cf));
+}
+
+/*! Calculate the cost metrics of the floating-point lowering of fp in the 
+ *  units of kdiv_stats_u/s: load of c, cvt, fmul and cvtt.
+ */
+int kdiv_stats_fp(struct kdiv_stats *st, const struct kdiv_fp *fp)
+{
+  if ((st == NULL) || (fp == NULL))
+  {
+    return (KDIV_E_ARG);
+  }
+  memset(st, 0, sizeof(*st));
+  // li (off the critical path), cvt, fmul, cvtt
+  st->muls  = 1;
+  st->ops   = 4;
+  st->depth = 3;
+  st->lat   = 2*KDIV_LAT_CVT + KDIV_LAT_FMUL;
+  return (KDIV_OK);
+}
+
+/*! Emit the name of the integer routine of the divisor of fp, e.g. 
+ *  "kdiv_u32_p_7"; the routines of fp append "_fp".
+ */
+static void emit_fp_name(struct kdiv_buf *f, const struct kdiv_fp *fp)
+{
+  struct kdiv_spec spec;
+  
+  spec.divisor   = (int)fp->d;
+  spec.width     = fp->W;
+  spec.is_signed = fp->is_signed;
+  spec.lang      = KDIV_LANG_ANSIC;
+  spec.mulwidth  = 0;
+  kdiv_routine_name(f, &spec);
+}
+
+/*! Emit the reciprocal of fp as an exact C99 hexadecimal floating constant.
+ */
+static void emit_fp_const(struct kdiv_buf *f, const struct kdiv_fp *fp)
+{
+  kdiv_bprintf(f, 0, "%s0x%llXp-%d%s", (fp->d < 0) ? "-" : "", fp->mc, fp->S,
+    (fp->dbl == 1) ? "" : "f");
+}
+
+/*! Emit the ANSI C routines of the floating-point lowering of fp: the 
+ *  scalar <name> and <name>_array, which processes 8/4 (AVX2) or 4/2 (SSE2)
+ *  float/double lanes per step when the lanes can hold the dividends and 
+ *  quotients as signed 32-bit integers. Both are exact only for the proven
+ *  dividends |n| <= fp->nmax.
+ */
+int kdiv_emit_fp_ansic(struct kdiv_buf *f, const struct kdiv_fp *fp)
+{
+  const char *T = (fp->is_signed == 0) ? "unsigned int" : "signed int";
+  const char *F = (fp->dbl == 1) ? "double" : "float";
+  unsigned long long int ad = (fp->d > 0) ? fp->d : -fp->d;
+  int simd, bias;
+  
+  // Unsigned dividends of 2^31 and above enter signed lanes biased by -2^31.
+  bias = (fp->is_signed == 0) && (fp->nmax > 0x7FFFFFFFULL);
+  simd = (bias == 0) || ((fp->dbl == 1) && (fp->nmax / ad <= 0x7FFFFFFFULL));
+  if (simd == 1)
+  {
+    kdiv_bprintf(f, 0, "#if defined(__AVX2__)\n");
+    kdiv_bprintf(f, 0, "#include <immintrin.h>\n");
+    kdiv_bprintf(f, 0, "#elif defined(__SSE2__)\n");
+    kdiv_bprintf(f, 0, "#include <emmintrin.h>\n");
+    kdiv_bprintf(f, 0, "#endif\n");
+  }
+  kdiv_bprintf(f, 0, "/* Exact for dividends %s%llu <= n <= %llu. */\n", 
+    (fp->is_signed == 0) ? "" : "-", (fp->is_signed == 0) ? 0ULL : fp->nmax, 
+    fp->nmax);
+  kdiv_bprintf(f, 0, "%s ", T);
+  emit_fp_name(f, fp);
+  kdiv_bprintf(f, 0, "_fp (%s n)\n", T);
+  kdiv_bprintf(f, 0, "{\n");
+  kdiv_bprintf(f, 2, "return ((%s)((%s)n * ", T, F);
+  emit_fp_const(f, fp);
+  kdiv_bprintf(f, 0, "));\n");
+  kdiv_bprintf(f, 0, "}\n");
+  
+  kdiv_bprintf(f, 0, "void ");
+  emit_fp_name(f, fp);
+  kdiv_bprintf(f, 0, "_fp_array (%s *q, const %s *n, unsigned long int len)\n", T, T);
+  kdiv_bprintf(f, 0, "{\n");
+  kdiv_bprintf(f, 2, "unsigned long int i = 0;\n");
+  if (simd == 1)
+  {
+    kdiv_bprintf(f, 0, "#if defined(__AVX2__)\n");
+    kdiv_bprintf(f, 2, "unsigned long int nv = len - len %% %d;\n", 
+      (fp->dbl == 1) ? 4 : 8);
+    kdiv_bprintf(f, 2, "for (; i < nv; i += %d)\n", (fp->dbl == 1) ? 4 : 8);
+    kdiv_bprintf(f, 2, "{\n");
+    if (fp->dbl == 0)
+    {
+      kdiv_bprintf(f, 4, "__m256 x = _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i *)(n + i)));\n");
+      kdiv_bprintf(f, 4, "x = _mm256_mul_ps(x, _mm256_set1_ps(");
+      emit_fp_const(f, fp);
+      kdiv_bprintf(f, 0, "));\n");
+      kdiv_bprintf(f, 4, "_mm256_storeu_si256((__m256i *)(q + i), _mm256_cvttps_epi32(x));\n");
+    }
+    else
+    {
+      kdiv_bprintf(f, 4, "__m128i v = _mm_loadu_si128((const __m128i *)(n + i));\n");
+      if (bias == 1)
+      {
+        kdiv_bprintf(f, 4, "__m256d x = _mm256_cvtepi32_pd(_mm_xor_si128(v, _mm_set1_epi32(-2147483647-1)));\n");
+        kdiv_bprintf(f, 4, "x = _mm256_add_pd(x, _mm256_set1_pd(2147483648.0));\n");
+      }
+      else
+      {
+        kdiv_bprintf(f, 4, "__m256d x = _mm256_cvtepi32_pd(v);\n");
+      }
+      kdiv_bprintf(f, 4, "x = _mm256_mul_pd(x, _mm256_set1_pd(");
+      emit_fp_const(f, fp);
+      kdiv_bprintf(f, 0, "));\n");
+      kdiv_bprintf(f, 4, "_mm_storeu_si128((__m128i *)(q + i), _mm256_cvttpd_epi32(x));\n");
+    }
+    kdiv_bprintf(f, 2, "}\n");
+    kdiv_bprintf(f, 0, "#elif defined(__SSE2__)\n");
+    kdiv_bprintf(f, 2, "unsigned long int nv = len - len %% %d;\n", 
+      (fp->dbl == 1) ? 2 : 4);
+    kdiv_bprintf(f, 2, "for (; i < nv; i += %d)\n", (fp->dbl == 1) ? 2 : 4);
+    kdiv_bprintf(f, 2, "{\n");
+    if (fp->dbl == 0)
+    {
+      kdiv_bprintf(f, 4, "__m128 x = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)(n + i)));\n");
+      kdiv_bprintf(f, 4, "x = _mm_mul_ps(x, _mm_set1_ps(");
+      emit_fp_const(f, fp);
+      kdiv_bprintf(f, 0, "));\n");
+      kdiv_bprintf(f, 4, "_mm_storeu_si128((__m128i *)(q + i), _mm_cvttps_epi32(x));\n");
+    }
+    else
+    {
+      kdiv_bprintf(f, 4, "__m128i v = _mm_loadl_epi64((const __m128i *)(n + i));\n");
+      if (bias == 1)
+      {
+        kdiv_bprintf(f, 4, "__m128d x = _mm_cvtepi32_pd(_mm_xor_si128(v, _mm_set1_epi32(-2147483647-1)));\n");
+        kdiv_bprintf(f, 4, "x = _mm_add_pd(x, _mm_set1_pd(2147483648.0));\n");
+      }
+      else
+      {
+        kdiv_bprintf(f, 4, "__m128d x = _mm_cvtepi32_pd(v);\n");
+      }
+      kdiv_bprintf(f, 4, "x = _mm_mul_pd(x, _mm_set1_pd(");
+      emit_fp_const(f, fp);
+      kdiv_bprintf(f, 0, "));\n");
+      kdiv_bprintf(f, 4, "_mm_storel_epi64((__m128i *)(q + i), _mm_cvttpd_epi32(x));\n");
+    }
+    kdiv_bprintf(f, 2, "}\n");
+    kdiv_bprintf(f, 0, "#endif\n");
+  }
+  kdiv_bprintf(f, 2, "for (; i < len; i++)\n");
+  kdiv_bprintf(f, 4, "q[i] = ");
+  emit_fp_name(f, fp);
+  kdiv_bprintf(f, 0, "_fp(n[i]);\n");
+  return (kdiv_bprintf(f, 0, "}\n"));
+}
+
+/*! Emit a benchmark driver for the routines of fp (included from kname) and
+ *  the integer routine of the same divisor (width 32 only): it checks both
+ *  against hardware division on random dividends of the proven range and 
+ *  reports the time per division of each form and the faster one.
+ */
+int kdiv_emit_fp_bench_ansic(struct kdiv_buf *f, const struct kdiv_fp *fp, 
+  const char *kname)
+{
+  const char *T = (fp->is_signed == 0) ? "unsigned int" : "signed int";
+  const char *names[4] = {"hardware div", "integer", "fp", "fp array"};
+  struct mu magu;
+  struct ms mags;
+  long long nlo, nhi;
+  char name[64];
+  struct kdiv_buf nb;
+  
+  if ((fp->W != 32) || (kname == NULL))
+  {
+    return (KDIV_E_ARG);
+  }
+  kdiv_buf_init(&nb, name, sizeof(name));
+  emit_fp_name(&nb, fp);
+  nlo = (fp->is_signed == 0) ? 0 : -(long long)fp->nmax;
+  nhi = (fp->is_signed == 0) ? (long long)fp->nmax 
+      : (fp->nmax > 0x7FFFFFFFULL) ? 0x7FFFFFFFLL : (long long)fp->nmax;
+  
+  kdiv_bprintf(f, 0, "#include <stdio.h>\n");
+  kdiv_bprintf(f, 0, "#include <time.h>\n");
+  kdiv_bprintf(f, 0, "#include \"%s\"\n", kname);
+  if (fp->is_signed == 0)
+  {
+    magu = kdiv_magicu((unsigned int)fp->d, fp->W);
+    emit_kdivu_ansic(f, magu.M, magu.a, magu.s, (unsigned int)fp->d, fp->W);
+  }
+  else
+  {
+    mags = kdiv_magic((int)fp->d, fp->W);
+    emit_kdivs_ansic(f, mags.M, mags.s, (int)fp->d, fp->W);
+  }
+  kdiv_bprintf(f, 0, "#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))\n");
+  kdiv_bprintf(f, 0, "#define CYCLES() __builtin_ia32_rdtsc()\n");
+  kdiv_bprintf(f, 0, "#else\n");
+  kdiv_bprintf(f, 0, "#define CYCLES() 0ULL\n");
+  kdiv_bprintf(f, 0, "#endif\n");
+  kdiv_bprintf(f, 0, "#define N    4096\n");
+  kdiv_bprintf(f, 0, "#define REPS 4000\n");
+  kdiv_bprintf(f, 0, "static %s n[N], q[4][N];\n", T);
+  kdiv_bprintf(f, 0, "volatile %s divisor = %lld;\n", T, fp->d);
+  kdiv_bprintf(f, 0, "static void run (int k, %s d)\n", T);
+  kdiv_bprintf(f, 0, "{\n");
+  kdiv_bprintf(f, 2, "int i;\n");
+  kdiv_bprintf(f, 2, "if (k == 0)\n");
+  kdiv_bprintf(f, 4, "for (i = 0; i < N; i++)\n");
+  kdiv_bprintf(f, 6, "q[0][i] = n[i] / d;\n");
+  kdiv_bprintf(f, 2, "else if (k == 1)\n");
+  kdiv_bprintf(f, 4, "for (i = 0; i < N; i++)\n");
+  kdiv_bprintf(f, 6, "q[1][i] = %s(n[i]);\n", name);
+  kdiv_bprintf(f, 2, "else if (k == 2)\n");
+  kdiv_bprintf(f, 4, "for (i = 0; i < N; i++)\n");
+  kdiv_bprintf(f, 6, "q[2][i] = %s_fp(n[i]);\n", name);
+  kdiv_bprintf(f, 2, "else\n");
+  kdiv_bprintf(f, 4, "%s_fp_array(q[3], n, N);\n", name);
+  kdiv_bprintf(f, 0, "}\n");
+  kdiv_bprintf(f, 0, "int main(void)\n");
+  kdiv_bprintf(f, 0, "{\n");
+  kdiv_bprintf(f, 2, "static const char *names[4] = {\"%s\", \"%s\", \"%s\", \"%s\"};\n",
+    names[0], names[1], names[2], names[3]);
+  kdiv_bprintf(f, 2, "unsigned long long int x = 12345, y0, y1;\n");
+  kdiv_bprintf(f, 2, "%s d = divisor;\n", T);
+  kdiv_bprintf(f, 2, "double t[4];\n");
+  kdiv_bprintf(f, 2, "clock_t c0;\n");
+  kdiv_bprintf(f, 2, "int i, j, k, best = 1, errors = 0;\n");
+  kdiv_bprintf(f, 2, "for (i = 0; i < N; i++)\n");
+  kdiv_bprintf(f, 2, "{\n");
+  kdiv_bprintf(f, 4, "x = x * 6364136223846793005ULL + 1442695040888963407ULL;\n");
+  kdiv_bprintf(f, 4, "n[i] = (%s)(%lldLL + (long long)((x >> 16) %% %lluULL));\n", 
+    T, nlo, (unsigned long long int)(nhi - nlo) + 1);
+  kdiv_bprintf(f, 2, "}\n");
+  kdiv_bprintf(f, 2, "n[0] = (%s)%lldLL;\n", T, nlo);
+  kdiv_bprintf(f, 2, "n[1] = (%s)%lldLL;\n", T, nhi);
+  kdiv_bprintf(f, 2, "for (k = 0; k < 4; k++)\n");
+  kdiv_bprintf(f, 2, "{\n");
+  kdiv_bprintf(f, 4, "c0 = clock();\n");
+  kdiv_bprintf(f, 4, "y0 = CYCLES();\n");
+  kdiv_bprintf(f, 4, "for (j = 0; j < REPS; j++)\n");
+  kdiv_bprintf(f, 6, "run(k, d);\n");
+  kdiv_bprintf(f, 4, "y1 = CYCLES();\n");
+  kdiv_bprintf(f, 4, "t[k] = 1e9 * (clock() - c0) / CLOCKS_PER_SEC / ((double)N * REPS);\n");
+  kdiv_bprintf(f, 4, "for (i = 0; i < N; i++)\n");
+  kdiv_bprintf(f, 6, "errors += (q[k][i] != q[0][i]);\n");
+  kdiv_bprintf(f, 4, "printf(\"%%-12s %%8.3f ns/div\", names[k], t[k]);\n");
+  kdiv_bprintf(f, 4, "if (y1 != y0)\n");
+  kdiv_bprintf(f, 6, "printf(\", %%6.3f cycles/div\", (double)(y1 - y0) / ((double)N * REPS));\n");
+  kdiv_bprintf(f, 4, "printf(\"\\n\");\n");
+  kdiv_bprintf(f, 4, "if ((k > 1) && (t[k] < t[best]))\n");
+  kdiv_bprintf(f, 6, "best = k;\n");
+  kdiv_bprintf(f, 2, "}\n");
+  kdiv_bprintf(f, 2, "printf(\"divisor %lld: %%d errors, faster form: %%s\\n\", errors, names[best]);\n", 
+    fp->d);
+  kdiv_bprintf(f, 2, "return (errors != 0);\n");
+  return (kdiv_bprintf(f, 0, "}\n"));
+}
+
+/*!
+   NOTES on the interleaved batch routines.
+12) The routine of 1) to 5) is applied to N independent lanes (N = 2, 4 or 
+   8), one step of the sequence at a time for all lanes: all high 
+   multiplies first, then the add/sub corrections, then the shifts and the
+   sign corrections. Consecutive operations are independent, so a 
+   superscalar core can issue a multiply every cycle instead of waiting for
+   the latency of each one. The lanes are processed in groups of 
+   KDIV_BATCH_GROUP, so that their values stay in registers (eight lanes 
+   in one group spill on x86-64); the out-of-order core overlaps the 
+   groups. Shift pairs of the unsigned routine are merged (q = t >> (W+s)).
+   All lanes are loaded before any store, so in and out may alias.
+*/
+
+#define KDIV_BATCH_GROUP  4
+
+/*! Emit a list of the N lanes of prefix, e.g. "n0, n1, n2, n3". 
+ */
+static void emit_lanes(struct kdiv_buf *f, const char *prefix, int N)
+{
+  int i;
+  
+  for (i = 0; i < N; i++)
+  {
+    kdiv_bprintf(f, 0, "%s%s%d", (i > 0) ? ", " : "", prefix, i);
+  }
+}
+
+/*! Emit the ANSI C routine dividing the N values of in by the divisor of 
+ *  spec into out, with the lanes interleaved as in NOTES 12): void 
+ *  <name>_x<N> (const <T> *in, <T> *out). Only width 32 is supported, like
+ *  the single-value ANSI C routines, and without a split multiply.
+ */
+int kdiv_emit_batch_ansic(struct kdiv_buf *f, const struct kdiv_spec *spec, int N)
+{
+  const char *T;
+  struct mu magu;
+  struct ms mags;
+  int d, g, G, i, k, err;
+  
+  if ((f == NULL) || (spec == NULL) || ((N != 2) && (N != 4) && (N != 8)))
+  {
+    return (KDIV_E_ARG);
+  }
+  err = kdiv_check(spec->divisor, spec->width, spec->is_signed);
+  if (err != KDIV_OK)
+  {
+    return (err);
+  }
+  if ((spec->width != 32) || 
+      ((spec->mulwidth != 0) && (spec->mulwidth < spec->width)))
+  {
+    return (KDIV_E_UNSUPPORTED);
+  }
+  d = spec->divisor;
+  k = log2ceil(ABS(d));
+  T = (spec->is_signed == 0) ? "unsigned int" : "signed int";
+  memset(&magu, 0, sizeof(magu));
+  memset(&mags, 0, sizeof(mags));
+  if (spec->is_signed == 0)
+  {
+    magu = kdiv_magicu(d, 32);
+  }
+  else
+  {
+    mags = kdiv_magic(d, 32);
+  }
+  
+  kdiv_bprintf(f, 0, "void ");
+  kdiv_routine_name(f, spec);
+  kdiv_bprintf(f, 0, "_x%d (const %s *in, %s *out)\n", N, T, T);
+  kdiv_bprintf(f, 0, "{\n");
+  kdiv_bprintf(f, 2, "%s ", T);
+  emit_lanes(f, "n", N);
+  kdiv_bprintf(f, 0, ";\n");
+  kdiv_bprintf(f, 2, "%s ", T);
+  emit_lanes(f, "q", N);
+  if (spec->is_signed == 0)
+  {
+    if (ispowof2(d) == 1)
+    {
+      kdiv_bprintf(f, 0, ";\n");
+    }
+    else
+    {
+      kdiv_bprintf(f, 0, ", M=%u;\n", magu.M);
+    }
+    if ((ispowof2(d) == 0) && (magu.a == 1))
+    {
+      kdiv_bprintf(f, 2, "unsigned long long int ");
+      emit_lanes(f, "t", N);
+      kdiv_bprintf(f, 0, ";\n");
+    }
+  }
+  else
+  {
+    if ((ABS(d) == 1) || (ispowof2(ABS(d)) == 1))
+    {
+      kdiv_bprintf(f, 0, ";\n");
+    }
+    else
+    {
+      kdiv_bprintf(f, 0, ", M=%d;\n", mags.M);
+    }
+  }
+  for (i = 0; i < N; i++)
+  {
+    kdiv_bprintf(f, 2, "n%d = in[%d];\n", i, i);
+  }
+  // Groups of up to KDIV_BATCH_GROUP lanes
+  for (g = 0; g < N; g += KDIV_BATCH_GROUP)
+  {
+    G = (g + KDIV_BATCH_GROUP < N) ? g + KDIV_BATCH_GROUP : N;
+    if (spec->is_signed == 0)
+    {
+      if (ispowof2(d) == 1)
+      {
+        for (i = g; i < G; i++)
+        {
+          kdiv_bprintf(f, 2, "q%d = n%d >> %d;\n", i, i, k);
+        }
+      }
+      else if (magu.a == 0)
+      {
+        // mulhu q, M, n and shri q, q, s merged
+        for (i = g; i < G; i++)
+        {
+          kdiv_bprintf(f, 2, "q%d = ((unsigned long long int)M * n%d) >> %d;\n", 
+            i, i, 32 + magu.s);
+        }
+      }
+      else
+      {
+        // mulhu q, M, n
+        for (i = g; i < G; i++)
+        {
+          kdiv_bprintf(f, 2, "q%d = ((unsigned long long int)M * n%d) >> 32;\n", i, i);
+        }
+        // add   q, q, n        // keeping the carry out of the 32-bit sum
+        for (i = g; i < G; i++)
+        {
+          kdiv_bprintf(f, 2, "t%d = (unsigned long long int)q%d + n%d;\n", i, i, i);
+        }
+        // shrxi q, q, s
+        for (i = g; i < G; i++)
+        {
+          kdiv_bprintf(f, 2, "q%d = t%d >> %d;\n", i, i, magu.s);
+        }
+      }
+    }
+    else if (ABS(d) == 1)
+    {
+      for (i = g; i < G; i++)
+      {
+        kdiv_bprintf(f, 2, "q%d = %sn%d;\n", i, (d < 0) ? "-" : "", i);
+      }
+    }
+    else if (ispowof2(ABS(d)) == 1)
+    {
+      // shrsi t, n, k-1 and shri t, t, 32-k: the bias 2^k-1 of n < 0
+      for (i = g; i < G; i++)
+      {
+        kdiv_bprintf(f, 2, "q%d = (signed int)((unsigned int)(n%d >> %d) >> %d);\n", 
+          i, i, k-1, 32-k);
+      }
+      // add   t, n, t and shrsi q, t, k
+      for (i = g; i < G; i++)
+      {
+        kdiv_bprintf(f, 2, "q%d = (n%d + q%d) >> %d;\n", i, i, i, k);
+      }
+      // neg   q, q                // for negative divisors (d < 0)
+      if (d < 0)
+      {
+        for (i = g; i < G; i++)
+        {
+          kdiv_bprintf(f, 2, "q%d = -q%d;\n", i, i);
+        }
+      }
+    }
+    else
+    {
+      // mulhs q, M, n
+      for (i = g; i < G; i++)
+      {
+        kdiv_bprintf(f, 2, "q%d = ((signed long long int)M * n%d) >> 32;\n", i, i);
+      }
+      // add|sub  q, q, n             // correction term for certain divisors
+      if (((d > 0) && (mags.M < 0)) || ((d < 0) && (mags.M > 0)))
+      {
+        for (i = g; i < G; i++)
+        {
+          kdiv_bprintf(f, 2, "q%d = q%d %c n%d;\n", i, i, (d > 0) ? '+' : '-', i);
+        }
+      }
+      if (mags.s > 0)
+      {
+        // shrsi q, q, s
+        for (i = g; i < G; i++)
+        {
+          kdiv_bprintf(f, 2, "q%d = q%d >> %d;\n", i, i, mags.s);
+        }
+      }
+      // shri  t, n, 31 and add q, q, t    // q for d < 0
+      for (i = g; i < G; i++)
+      {
+        kdiv_bprintf(f, 2, "q%d = q%d + (signed int)((unsigned int)%c%d >> 31);\n", 
+          i, i, (d < 0) ? 'q' : 'n', i);
+      }
+    }
+  }
+  for (i = 0; i < N; i++)
+  {
+    kdiv_bprintf(f, 2, "out[%d] = q%d;\n", i, i);
+  }
+  return (kdiv_bprintf(f, 0, "}\n"));
+}
+
+/*! Emit a benchmark driver for the batch routines of the divisor of spec 
+ *  (width 32): it emits the single-value routine and the routines for 
+ *  N = 2, 4 and 8, checks them against hardware division on random 
+ *  dividends and reports the time per division of each and the speedup of
+ *  the batch routines over the single-value one. The dividends are gathered
+ *  once through a random permutation, outside the timed loops, and every 
+ *  variant reads them from and writes the quotients to the same buffers.
+ *  Vectorization is disabled (GCC and Clang), so that all variants run as
+ *  scalar code, as for values that cannot be vectorized; each time is the 
+ *  best of several rounds that run all variants in turn.
+ */
+int kdiv_emit_batch_bench_ansic(struct kdiv_buf *f, const struct kdiv_spec *spec)
+{
+  const char *T;
+  struct kdiv_spec sc;
+  char name[64];
+  struct kdiv_buf nb;
+  int N, k, err;
+  
+  if ((f == NULL) || (spec == NULL))
+  {
+    return (KDIV_E_ARG);
+  }
+  sc = *spec;
+  sc.lang = KDIV_LANG_ANSIC;
+  sc.mulwidth = 0;
+  T = (sc.is_signed == 0) ? "unsigned int" : "signed int";
+  kdiv_buf_init(&nb, name, sizeof(name));
+  kdiv_routine_name(&nb, &sc);
+  
+  kdiv_bprintf(f, 0, "#include <stdio.h>\n");
+  kdiv_bprintf(f, 0, "#include <time.h>\n");
+  // Time scalar code only, the routines included: the batch routines are
+  // for values that cannot be vectorized.
+  kdiv_bprintf(f, 0, "#if defined(__clang__)\n");
+  kdiv_bprintf(f, 0, "#define SCALAR _Pragma(\"clang loop vectorize(disable)\")\n");
+  kdiv_bprintf(f, 0, "#else\n");
+  kdiv_bprintf(f, 0, "#if defined(__GNUC__)\n");
+  kdiv_bprintf(f, 0, "#pragma GCC optimize(\"no-tree-vectorize\")\n");
+  kdiv_bprintf(f, 0, "#endif\n");
+  kdiv_bprintf(f, 0, "#define SCALAR\n");
+  kdiv_bprintf(f, 0, "#endif\n");
+  err = kdiv_generate(f, &sc);
+  for (N = 2; (N <= 8) && (err == KDIV_OK); N *= 2)
+  {
+    err = kdiv_emit_batch_ansic(f, &sc, N);
+  }
+  if (err != KDIV_OK)
+  {
+    return (err);
+  }
+  kdiv_bprintf(f, 0, "#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))\n");
+  kdiv_bprintf(f, 0, "#define CYCLES() __builtin_ia32_rdtsc()\n");
+  kdiv_bprintf(f, 0, "#else\n");
+  kdiv_bprintf(f, 0, "#define CYCLES() 0ULL\n");
+  kdiv_bprintf(f, 0, "#endif\n");
+  kdiv_bprintf(f, 0, "#define N    4096\n");
+  kdiv_bprintf(f, 0, "#define REPS 400\n");
+  kdiv_bprintf(f, 0, "#define TRIALS 10\n");
+  kdiv_bprintf(f, 0, "static %s n[N], g[N], q[5][N];\n", T);
+  kdiv_bprintf(f, 0, "static int p[N];\n");
+  kdiv_bprintf(f, 0, "volatile %s divisor = %d;\n", T, sc.divisor);
+  kdiv_bprintf(f, 0, "static void run (int k, %s d)\n", T);
+  kdiv_bprintf(f, 0, "{\n");
+  kdiv_bprintf(f, 2, "int i;\n");
+  kdiv_bprintf(f, 2, "if (k == 0)\n");
+  kdiv_bprintf(f, 4, "for (i = 0; i < N; i++)\n");
+  kdiv_bprintf(f, 6, "q[0][i] = g[i] / d;\n");
+  kdiv_bprintf(f, 2, "else if (k == 1)\n");
+  kdiv_bprintf(f, 4, "SCALAR for (i = 0; i < N; i++)\n");
+  kdiv_bprintf(f, 6, "q[1][i] = %s(g[i]);\n", name);
+  for (N = 2, k = 2; N <= 8; N *= 2, k++)
+  {
+    if (N < 8)
+    {
+      kdiv_bprintf(f, 2, "else if (k == %d)\n", k);
+    }
+    else
+    {
+      kdiv_bprintf(f, 2, "else\n");
+    }
+    kdiv_bprintf(f, 4, "SCALAR for (i = 0; i < N; i += %d)\n", N);
+    kdiv_bprintf(f, 6, "%s_x%d(g + i, q[%d] + i);\n", name, N, k);
+  }
+  kdiv_bprintf(f, 0, "}\n");
+  kdiv_bprintf(f, 0, "int main(void)\n");
+  kdiv_bprintf(f, 0, "{\n");
+  kdiv_bprintf(f, 2, "static const char *names[5] = {\"hardware div\", \"x1\", \"x2\", \"x4\", \"x8\"};\n");
+  kdiv_bprintf(f, 2, "unsigned long long int x = 12345, y0, y1;\n");
+  kdiv_bprintf(f, 2, "double t[5], c[5], u;\n");
+  kdiv_bprintf(f, 2, "%s d = divisor;\n", T);
+  kdiv_bprintf(f, 2, "clock_t c0;\n");
+  kdiv_bprintf(f, 2, "int i, j, k, r, errors = 0;\n");
+  kdiv_bprintf(f, 2, "for (i = 0; i < N; i++)\n");
+  kdiv_bprintf(f, 2, "{\n");
+  kdiv_bprintf(f, 4, "x = x * 6364136223846793005ULL + 1442695040888963407ULL;\n");
+  kdiv_bprintf(f, 4, "n[i] = (%s)(x >> 32);\n", T);
+  kdiv_bprintf(f, 4, "j = (int)((x >> 16) %% (unsigned long long int)(i + 1));\n");
+  kdiv_bprintf(f, 4, "p[i] = p[j];\n");
+  kdiv_bprintf(f, 4, "p[j] = i;\n");
+  kdiv_bprintf(f, 2, "}\n");
+  kdiv_bprintf(f, 2, "for (i = 0; i < N; i++)\n");
+  kdiv_bprintf(f, 4, "g[i] = n[p[i]];\n");
+  kdiv_bprintf(f, 2, "// Best of TRIALS rounds over all variants, after a warm-up.\n");
+  kdiv_bprintf(f, 2, "for (r = -1; r < TRIALS; r++)\n");
+  kdiv_bprintf(f, 2, "{\n");
+  kdiv_bprintf(f, 4, "for (k = 0; k < 5; k++)\n");
+  kdiv_bprintf(f, 4, "{\n");
+  kdiv_bprintf(f, 6, "c0 = clock();\n");
+  kdiv_bprintf(f, 6, "y0 = CYCLES();\n");
+  kdiv_bprintf(f, 6, "for (j = 0; j < REPS; j++)\n");
+  kdiv_bprintf(f, 8, "run(k, d);\n");
+  kdiv_bprintf(f, 6, "y1 = CYCLES();\n");
+  kdiv_bprintf(f, 6, "u = 1e9 * (clock() - c0) / CLOCKS_PER_SEC / ((double)N * REPS);\n");
+  kdiv_bprintf(f, 6, "t[k] = ((r <= 0) || (u < t[k])) ? u : t[k];\n");
+  kdiv_bprintf(f, 6, "u = (double)(y1 - y0) / ((double)N * REPS);\n");
+  kdiv_bprintf(f, 6, "c[k] = ((r <= 0) || (u < c[k])) ? u : c[k];\n");
+  kdiv_bprintf(f, 4, "}\n");
+  kdiv_bprintf(f, 2, "}\n");
+  kdiv_bprintf(f, 2, "for (k = 0; k < 5; k++)\n");
+  kdiv_bprintf(f, 2, "{\n");
+  kdiv_bprintf(f, 4, "for (i = 0; i < N; i++)\n");
+  kdiv_bprintf(f, 6, "errors += (q[k][i] != q[0][i]);\n");
+  kdiv_bprintf(f, 4, "printf(\"%%-12s %%8.3f ns/div\", names[k], t[k]);\n");
+  kdiv_bprintf(f, 4, "if (c[k] > 0.0)\n");
+  kdiv_bprintf(f, 6, "printf(\", %%6.3f cycles/div\", c[k]);\n");
+  kdiv_bprintf(f, 4, "if ((k > 1) && (t[k] > 0.0))\n");
+  kdiv_bprintf(f, 6, "printf(\", %%5.2fx over x1\", t[1] / t[k]);\n");
+  kdiv_bprintf(f, 4, "printf(\"\\n\");\n");
+  kdiv_bprintf(f, 2, "}\n");
+  kdiv_bprintf(f, 2, "printf(\"divisor %d: %%d errors\\n\", errors);\n", sc.divisor);
+  kdiv_bprintf(f, 2, "return (errors != 0);\n");
+  return (kdiv_bprintf(f, 0, "}\n"));
+}
+
+/*! Emit the self-test harness of the routine of spec (ANSI C, width 32): 
+ *  it includes the emitted file kname unchanged and adds 
+ *  <name>_selftest (q, first, count), storing the quotients of the dividends
+ *  first, first+1, ... (as 32-bit patterns) to q. The routine is inlined in 
+ *  the loop, which the compiler is free to vectorize.
+ */
+int kdiv_emit_selftest_ansic(struct kdiv_buf *f, const struct kdiv_spec *spec, 
+  const char *kname)
+{
+  char name[64];
+  struct kdiv_buf nb;
+  int err;
+  
+  if ((f == NULL) || (spec == NULL) || (kname == NULL))
+  {
+    return (KDIV_E_ARG);
+  }
+  err = kdiv_check(spec->divisor, spec->width, spec->is_signed);
+  if (err != KDIV_OK)
+  {
+    return (err);
+  }
+  if ((spec->width != 32) || (spec->lang != KDIV_LANG_ANSIC))
+  {
+    return (KDIV_E_UNSUPPORTED);
+  }
+  kdiv_buf_init(&nb, name, sizeof(name));
+  kdiv_routine_name(&nb, spec);
+  
+  kdiv_bprintf(f, 0, "#include \"%s\"\n", kname);
+  kdiv_bprintf(f, 0, "void %s_selftest (unsigned int *q, unsigned int first, unsigned int count)\n", name);
+  kdiv_bprintf(f, 0, "{\n");
+  kdiv_bprintf(f, 2, "unsigned int i;\n");
+  kdiv_bprintf(f, 2, "for (i = 0; i < count; i++)\n");
+  if (spec->is_signed == 0)
+  {
+    kdiv_bprintf(f, 4, "q[i] = %s(first + i);\n", name);
+  }
+  else
+  {
+    kdiv_bprintf(f, 4, "q[i] = (unsigned int)%s((signed int)(first + i));\n", name);
+  }
+  return (kdiv_bprintf(f, 0, "}\n"));
+}
+
+/*!
+   NOTES on the per-lane (dictionary) routines.
+13) With the divisor of each element taken from a small dictionary, the 
+   routines of 1) to 5) are unified into one branch-free sequence whose 
+   parameters are looked up (gathered) per element:
+  mulhu|mulhs h, M, n
+  and   u, n, A             // A = -1 if KDIV_LANE_ADD, else 0
+  add   t, h, u             // unsigned: with carry c into bit 32
+  shr   q, t:c, s           // (t >> s) | (c << (32-s)), as 0 for s = 0
+   Unsigned powers of 2 (and d = 1) use M = 0, A = -1 and s = k; the other
+   divisors are those of kdiv_magicu. Signed divisors use the magic of 
+   kdiv_magic, which is also exact for powers of 2; the term u is n or -n 
+   (the add|sub correction), the shift is arithmetic and the sign 
+   correction adds the sign bit of n (or of q, for d < 0). For |d| = 1, M = 0, u = n or -n and
+   the sign correction is masked off. The vector shifts by lane (vpsrlvd, 
+   vpsllvd, vpsravd) give 0 for counts of 32, so c << (32-s) needs no test.
+*/
+
+/*! Calculate the dictionary parameters of d (width 32), following NOTES 13).
+ */
+int kdiv_lane(struct kdiv_lane *l, int d, int is_signed)
+{
+  struct mu magu;
+  struct ms mags;
+  int err;
+  
+  if (l == NULL)
+  {
+    return (KDIV_E_ARG);
+  }
+  err = kdiv_check(d, 32, is_signed);
+  if (err != KDIV_OK)
+  {
+    return (err);
+  }
+  l->d = d;
+  if (is_signed == 0)
+  {
+    if (ispowof2(d) == 1)
+    {
+      l->M = 0;
+      l->w = KDIV_LANE_ADD | (unsigned int)log2ceil(d);
+    }
+    else
+    {
+      magu = kdiv_magicu(d, 32);
+      l->M = magu.M;
+      l->w = (unsigned int)magu.s | ((magu.a == 1) ? KDIV_LANE_ADD : 0);
+    }
+  }
+  else if (ABS(d) == 1)
+  {
+    l->M = 0;
+    l->w = KDIV_LANE_ADD | ((d < 0) ? KDIV_LANE_NEG : 0);
+  }
+  else
+  {
+    mags = kdiv_magic(d, 32);
+    l->M = (unsigned int)mags.M;
+    l->w = (unsigned int)mags.s | KDIV_LANE_SIGN;
+    if ((d > 0) && (mags.M < 0))
+    {
+      l->w = l->w | KDIV_LANE_ADD;
+    }
+    else if ((d < 0) && (mags.M > 0))
+    {
+      l->w = l->w | KDIV_LANE_ADD | KDIV_LANE_NEG;
+    }
+    if (d < 0)
+    {
+      l->w = l->w | KDIV_LANE_QSIGN;
+    }
+  }
+  return (KDIV_OK);
+}
+
+/*! Perform an unsigned division by the divisor of l with the 32-bit 
+ *  operations of the vector sequence of NOTES 13).
+ */
+unsigned int kdiv_calculate_u_lane(const struct kdiv_lane *l, unsigned int n)
+{
+  unsigned int h, u, t, c, s;
+  
+  h = ((unsigned long long int)l->M * n) >> 32;
+  u = n & (0U - ((l->w & KDIV_LANE_ADD) >> 8));
+  t = h + u;
+  // Carry out of bit 31 of h + u.
+  c = ((h & u) | ((h | u) & ~t)) >> 31;
+  s = l->w & KDIV_LANE_SHIFT;
+  return ((t >> s) | ((s > 0) ? (c << (32 - s)) : 0));
+}
+
+/*! Perform a signed division by the divisor of l with the 32-bit operations
+ *  of the vector sequence of NOTES 13).
+ */
+int kdiv_calculate_s_lane(const struct kdiv_lane *l, int n)
+{
+  unsigned int nu = (unsigned int)n, x, a, qs, sel;
+  int q;
+  
+  q = ((signed long long int)(int)l->M * n) >> 32;
+  // add|sub  q, q, n: u = ((n ^ x) - x) & a, with x = -1 for -n
+  x = 0U - ((l->w & KDIV_LANE_NEG) >> 9);
+  a = 0U - ((l->w & KDIV_LANE_ADD) >> 8);
+  q = (int)((unsigned int)q + (((nu ^ x) - x) & a));
+  q = q >> (l->w & KDIV_LANE_SHIFT);
+  qs = 0U - ((l->w & KDIV_LANE_QSIGN) >> 10);
+  sel = (nu & ~qs) | ((unsigned int)q & qs);
+  return ((int)((unsigned int)q + ((sel >> 31) & ((l->w & KDIV_LANE_SIGN) >> 11))));
+}
+
+/*! Emit the vector loop of the dictionary array routine for AVX-512 (16 
+ *  lanes) or AVX2 (8 lanes); tab is the prefix of the M and w tables.
+ */
+static void emit_dict_simd(struct kdiv_buf *f, const char *tab, int is_signed,
+  int avx512)
+{
+  const char *V = (avx512 == 1) ? "_mm512" : "_mm256";
+  const char *T = (avx512 == 1) ? "__m512i" : "__m256i";
+  const char *SI = (avx512 == 1) ? "si512" : "si256";
+  const char *mul = (is_signed == 0) ? "mul_epu32" : "mul_epi32";
+  int L = (avx512 == 1) ? 16 : 8;
+  
+  kdiv_bprintf(f, 2, "unsigned long int nv = len - len %% %d;\n", L);
+  kdiv_bprintf(f, 2, "for (; i < nv; i += %d)\n", L);
+  kdiv_bprintf(f, 2, "{\n");
+  if (avx512 == 1)
+  {
+    kdiv_bprintf(f, 4, "%s x = _mm512_loadu_si512((const void *)(n + i));\n", T);
+    kdiv_bprintf(f, 4, "%s j = _mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i *)(idx + i)));\n", T);
+    kdiv_bprintf(f, 4, "%s m = _mm512_i32gather_epi32(j, (const void *)%s_M, 4);\n", T, tab);
+    kdiv_bprintf(f, 4, "%s w = _mm512_i32gather_epi32(j, (const void *)%s_w, 4);\n", T, tab);
+  }
+  else
+  {
+    kdiv_bprintf(f, 4, "%s x = _mm256_loadu_si256((const __m256i *)(n + i));\n", T);
+    kdiv_bprintf(f, 4, "%s j = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(idx + i)));\n", T);
+    kdiv_bprintf(f, 4, "%s m = _mm256_i32gather_epi32((const int *)%s_M, j, 4);\n", T, tab);
+    kdiv_bprintf(f, 4, "%s w = _mm256_i32gather_epi32((const int *)%s_w, j, 4);\n", T, tab);
+  }
+  // High products of the even and of the odd lanes, merged.
+  kdiv_bprintf(f, 4, "%s he = %s_srli_epi64(%s_%s(m, x), 32);\n", T, V, V, mul);
+  kdiv_bprintf(f, 4, "%s ho = %s_%s(%s_srli_epi64(m, 32), %s_srli_epi64(x, 32));\n", 
+    T, V, mul, V, V);
+  if (avx512 == 1)
+  {
+    kdiv_bprintf(f, 4, "%s h = _mm512_mask_blend_epi32(0xAAAA, he, ho);\n", T);
+  }
+  else
+  {
+    kdiv_bprintf(f, 4, "%s h = _mm256_blend_epi32(he, ho, 0xAA);\n", T);
+  }
+  kdiv_bprintf(f, 4, "%s a = %s_srai_epi32(%s_slli_epi32(w, 23), 31);\n", T, V, V);
+  kdiv_bprintf(f, 4, "%s s = %s_and_%s(w, %s_set1_epi32(31));\n", T, V, SI, V);
+  if (is_signed == 0)
+  {
+    kdiv_bprintf(f, 4, "%s u = %s_and_%s(x, a);\n", T, V, SI);
+    kdiv_bprintf(f, 4, "%s t = %s_add_epi32(h, u);\n", T, V);
+    kdiv_bprintf(f, 4, "%s c = %s_or_%s(%s_and_%s(h, u), %s_andnot_%s(t, %s_or_%s(h, u)));\n", 
+      T, V, SI, V, SI, V, SI, V, SI);
+    kdiv_bprintf(f, 4, "c = %s_sllv_epi32(%s_srli_epi32(c, 31), %s_sub_epi32(%s_set1_epi32(32), s));\n", 
+      V, V, V, V);
+    kdiv_bprintf(f, 4, "t = %s_or_%s(%s_srlv_epi32(t, s), c);\n", V, SI, V);
+  }
+  else
+  {
+    kdiv_bprintf(f, 4, "%s g = %s_srai_epi32(%s_slli_epi32(w, 22), 31);\n", T, V, V);
+    kdiv_bprintf(f, 4, "%s u = %s_and_%s(%s_sub_epi32(%s_xor_%s(x, g), g), a);\n", 
+      T, V, SI, V, V, SI);
+    kdiv_bprintf(f, 4, "%s t = %s_srav_epi32(%s_add_epi32(h, u), s);\n", T, V, V);
+    kdiv_bprintf(f, 4, "g = %s_srai_epi32(%s_slli_epi32(w, 21), 31);\n", V, V);
+    kdiv_bprintf(f, 4, "u = %s_or_%s(%s_andnot_%s(g, x), %s_and_%s(g, t));\n", 
+      V, SI, V, SI, V, SI);
+    kdiv_bprintf(f, 4, "u = %s_and_%s(%s_srli_epi32(u, 31), %s_srli_epi32(w, 11));\n", 
+      V, SI, V, V);
+    kdiv_bprintf(f, 4, "t = %s_add_epi32(t, u);\n", V);
+  }
+  if (avx512 == 1)
+  {
+    kdiv_bprintf(f, 4, "_mm512_storeu_si512((void *)(q + i), t);\n");
+  }
+  else
+  {
+    kdiv_bprintf(f, 4, "_mm256_storeu_si256((__m256i *)(q + i), t);\n");
+  }
+  kdiv_bprintf(f, 2, "}\n");
+}
+
+/*! Emit the ANSI C routines dividing by the nl (at most 256) divisors of 
+ *  the dictionary l, following NOTES 13): the tables <name>_M and <name>_w,
+ *  the scalar <name> (n, i), dividing n by divisor i, and 
+ *  <name>_array (q, n, idx, len), dividing n[k] by divisor idx[k], which 
+ *  gathers the parameters of 16 (AVX-512) or 8 (AVX2) lanes per step. The
+ *  name is kdiv_<u|s>32_dict.
+ */
+int kdiv_emit_dict_ansic(struct kdiv_buf *f, const struct kdiv_lane *l, int nl, 
+  int is_signed)
+{
+  const char *T = (is_signed == 0) ? "unsigned int" : "signed int";
+  char tab[16];
+  int i;
+  
+  if ((f == NULL) || (l == NULL) || (nl < 1) || (nl > 256))
+  {
+    return (KDIV_E_ARG);
+  }
+  sprintf(tab, "kdiv_%c32_dict", (is_signed == 0) ? 'u' : 's');
+  kdiv_bprintf(f, 0, "#if defined(__AVX512F__) || defined(__AVX2__)\n");
+  kdiv_bprintf(f, 0, "#include <immintrin.h>\n");
+  kdiv_bprintf(f, 0, "#endif\n");
+  kdiv_bprintf(f, 0, "/* Divisors:");
+  for (i = 0; i < nl; i++)
+  {
+    kdiv_bprintf(f, 0, "%s%d", (i > 0) ? ", " : " ", l[i].d);
+  }
+  kdiv_bprintf(f, 0, ". */\n");
+  kdiv_bprintf(f, 0, "static const unsigned int %s_M[%d] = {", tab, nl);
+  for (i = 0; i < nl; i++)
+  {
+    kdiv_bprintf(f, 0, "%s%s0x%08XU", (i > 0) ? "," : "", 
+      ((i % 6) == 0) ? "\n  " : " ", l[i].M);
+  }
+  kdiv_bprintf(f, 0, "\n};\n");
+  kdiv_bprintf(f, 0, "static const unsigned int %s_w[%d] = {", tab, nl);
+  for (i = 0; i < nl; i++)
+  {
+    kdiv_bprintf(f, 0, "%s%s0x%03XU", (i > 0) ? "," : "", 
+      ((i % 8) == 0) ? "\n  " : " ", l[i].w);
+  }
+  kdiv_bprintf(f, 0, "\n};\n");
+  
+  kdiv_bprintf(f, 0, "%s %s (%s n, unsigned int i)\n", T, tab, T);
+  kdiv_bprintf(f, 0, "{\n");
+  kdiv_bprintf(f, 2, "unsigned int w = %s_w[i], a = 0U - ((w >> 8) & 1);\n", tab);
+  if (is_signed == 0)
+  {
+    kdiv_bprintf(f, 2, "unsigned long long int t;\n");
+    kdiv_bprintf(f, 2, "t = ((unsigned long long int)%s_M[i] * n) >> 32;\n", tab);
+    kdiv_bprintf(f, 2, "t = t + (n & a);\n");
+    kdiv_bprintf(f, 2, "return ((unsigned int)(t >> (w & 31)));\n");
+  }
+  else
+  {
+    kdiv_bprintf(f, 2, "unsigned int g = 0U - ((w >> 9) & 1), u;\n");
+    kdiv_bprintf(f, 2, "signed int q;\n");
+    kdiv_bprintf(f, 2, "q = ((signed long long int)(signed int)%s_M[i] * n) >> 32;\n", tab);
+    kdiv_bprintf(f, 2, "u = (((unsigned int)n ^ g) - g) & a;\n");
+    kdiv_bprintf(f, 2, "q = (signed int)((unsigned int)q + u) >> (w & 31);\n");
+    kdiv_bprintf(f, 2, "u = (unsigned int)(((w >> 10) & 1) ? q : n) >> 31;\n");
+    kdiv_bprintf(f, 2, "return (q + (signed int)(u & (w >> 11)));\n");
+  }
+  kdiv_bprintf(f, 0, "}\n");
+  
+  kdiv_bprintf(f, 0, "void %s_array (%s *q, const %s *n, const unsigned char *idx, unsigned long int len)\n", 
+    tab, T, T);
+  kdiv_bprintf(f, 0, "{\n");
+  kdiv_bprintf(f, 2, "unsigned long int i = 0;\n");
+  kdiv_bprintf(f, 0, "#if defined(__AVX512F__)\n");
+  emit_dict_simd(f, tab, is_signed, 1);
+  kdiv_bprintf(f, 0, "#elif defined(__AVX2__)\n");
+  emit_dict_simd(f, tab, is_signed, 0);
+  kdiv_bprintf(f, 0, "#endif\n");
+  kdiv_bprintf(f, 2, "for (; i < len; i++)\n");
+  kdiv_bprintf(f, 4, "q[i] = %s(n[i], idx[i]);\n", tab);
+  return (kdiv_bprintf(f, 0, "}\n"));
+}
+
+/*! Emit a benchmark driver for the dictionary routines of l (included from
+ *  kname): it checks the array routine against hardware division on random
+ *  dividends and divisor indices, and times hardware division, the scalar 
+ *  and the array routine. With the argument -all, it checks the array 
+ *  routine for every divisor over all 2^32 dividends instead.
+ */
+int kdiv_emit_dict_bench_ansic(struct kdiv_buf *f, const struct kdiv_lane *l, 
+  int nl, int is_signed, const char *kname)
+{
+  const char *T = (is_signed == 0) ? "unsigned int" : "signed int";
+  char tab[16];
+  int i;
+  
+  if ((f == NULL) || (l == NULL) || (nl < 1) || (nl > 256) || (kname == NULL))
+  {
+    return (KDIV_E_ARG);
+  }
+  sprintf(tab, "kdiv_%c32_dict", (is_signed == 0) ? 'u' : 's');
+  kdiv_bprintf(f, 0, "#include <stdio.h>\n");
+  kdiv_bprintf(f, 0, "#include <string.h>\n");
+  kdiv_bprintf(f, 0, "#include <time.h>\n");
+  kdiv_bprintf(f, 0, "#include \"%s\"\n", kname);
+  kdiv_bprintf(f, 0, "#define N    4096\n");
+  kdiv_bprintf(f, 0, "#define REPS 4000\n");
+  kdiv_bprintf(f, 0, "#define K    %d\n", nl);
+  kdiv_bprintf(f, 0, "static %s n[N], q[3][N];\n", T);
+  kdiv_bprintf(f, 0, "static unsigned char idx[N];\n");
+  kdiv_bprintf(f, 0, "volatile %s divisors[K] = {", T);
+  for (i = 0; i < nl; i++)
+  {
+    kdiv_bprintf(f, 0, "%s%d", (i > 0) ? ", " : "", l[i].d);
+  }
+  kdiv_bprintf(f, 0, "};\n");
+  kdiv_bprintf(f, 0, "static %s dv[K];\n", T);
+  kdiv_bprintf(f, 0, "static void run (int k)\n");
+  kdiv_bprintf(f, 0, "{\n");
+  kdiv_bprintf(f, 2, "int i;\n");
+  kdiv_bprintf(f, 2, "if (k == 0)\n");
+  kdiv_bprintf(f, 4, "for (i = 0; i < N; i++)\n");
+  kdiv_bprintf(f, 6, "q[0][i] = n[i] / dv[idx[i]];\n");
+  kdiv_bprintf(f, 2, "else if (k == 1)\n");
+  kdiv_bprintf(f, 4, "for (i = 0; i < N; i++)\n");
+  kdiv_bprintf(f, 6, "q[1][i] = %s(n[i], idx[i]);\n", tab);
+  kdiv_bprintf(f, 2, "else\n");
+  kdiv_bprintf(f, 4, "%s_array(q[2], n, idx, N);\n", tab);
+  kdiv_bprintf(f, 0, "}\n");
+  // Exhaustive check of one divisor, N dividends at a time.
+  kdiv_bprintf(f, 0, "static unsigned long long int check_all (int k)\n");
+  kdiv_bprintf(f, 0, "{\n");
+  kdiv_bprintf(f, 2, "unsigned long long int x, bad = 0;\n");
+  kdiv_bprintf(f, 2, "int i;\n");
+  kdiv_bprintf(f, 2, "memset(idx, k, sizeof(idx));\n");
+  kdiv_bprintf(f, 2, "for (x = 0; x < 4294967296ULL; x += N)\n");
+  kdiv_bprintf(f, 2, "{\n");
+  kdiv_bprintf(f, 4, "for (i = 0; i < N; i++)\n");
+  kdiv_bprintf(f, 6, "n[i] = (%s)(unsigned int)(x + i);\n", T);
+  kdiv_bprintf(f, 4, "%s_array(q[2], n, idx, N);\n", tab);
+  kdiv_bprintf(f, 4, "for (i = 0; i < N; i++)\n");
+  if (is_signed == 0)
+  {
+    kdiv_bprintf(f, 6, "bad += (q[2][i] != n[i] / dv[k]);\n");
+  }
+  else
+  {
+    kdiv_bprintf(f, 6, "bad += ((n[i] != -2147483647-1) || (dv[k] != -1)) && (q[2][i] != n[i] / dv[k]);\n");
+  }
+  kdiv_bprintf(f, 2, "}\n");
+  kdiv_bprintf(f, 2, "return (bad);\n");
+  kdiv_bprintf(f, 0, "}\n");
+  kdiv_bprintf(f, 0, "int main(int argc, char *argv[])\n");
+  kdiv_bprintf(f, 0, "{\n");
+  kdiv_bprintf(f, 2, "static const char *names[3] = {\"hardware div\", \"scalar\", \"array\"};\n");
+  kdiv_bprintf(f, 2, "unsigned long long int x = 12345, bad, errors = 0;\n");
+  kdiv_bprintf(f, 2, "clock_t c0;\n");
+  kdiv_bprintf(f, 2, "int i, j, k;\n");
+  kdiv_bprintf(f, 2, "for (k = 0; k < K; k++)\n");
+  kdiv_bprintf(f, 4, "dv[k] = divisors[k];\n");
+  kdiv_bprintf(f, 2, "if ((argc > 1) && (strcmp(argv[1], \"-all\") == 0))\n");
+  kdiv_bprintf(f, 2, "{\n");
+  kdiv_bprintf(f, 4, "for (k = 0; k < K; k++)\n");
+  kdiv_bprintf(f, 4, "{\n");
+  kdiv_bprintf(f, 6, "bad = check_all(k);\n");
+  kdiv_bprintf(f, 6, "printf(\"divisor %%d: %%llu errors over all dividends\\n\", (int)dv[k], bad);\n");
+  kdiv_bprintf(f, 6, "errors += bad;\n");
+  kdiv_bprintf(f, 4, "}\n");
+  kdiv_bprintf(f, 4, "return (errors != 0);\n");
+  kdiv_bprintf(f, 2, "}\n");
+  kdiv_bprintf(f, 2, "for (i = 0; i < N; i++)\n");
+  kdiv_bprintf(f, 2, "{\n");
+  kdiv_bprintf(f, 4, "x = x * 6364136223846793005ULL + 1442695040888963407ULL;\n");
+  kdiv_bprintf(f, 4, "n[i] = (%s)(x >> 32);\n", T);
+  if (is_signed == 1)
+  {
+    kdiv_bprintf(f, 4, "n[i] = (n[i] == -2147483647-1) ? 0 : n[i];\n");
+  }
+  kdiv_bprintf(f, 4, "idx[i] = (unsigned char)((x >> 16) %% K);\n");
+  kdiv_bprintf(f, 2, "}\n");
+  kdiv_bprintf(f, 2, "for (k = 0; k < 3; k++)\n");
+  kdiv_bprintf(f, 2, "{\n");
+  kdiv_bprintf(f, 4, "c0 = clock();\n");
+  kdiv_bprintf(f, 4, "for (j = 0; j < REPS; j++)\n");
+  kdiv_bprintf(f, 6, "run(k);\n");
+  kdiv_bprintf(f, 4, "printf(\"%%-12s %%8.3f ns/div\\n\", names[k], 1e9 * (clock() - c0) / CLOCKS_PER_SEC / ((double)N * REPS));\n");
+  kdiv_bprintf(f, 4, "for (i = 0; i < N; i++)\n");
+  kdiv_bprintf(f, 6, "errors += (q[k][i] != q[0][i]);\n");
+  kdiv_bprintf(f, 2, "}\n");
+  kdiv_bprintf(f, 2, "printf(\"%d divisors: %%llu errors\\n\", errors);\n", nl);
+  kdiv_bprintf(f, 2, "return (errors != 0);\n");
+  return (kdiv_bprintf(f, 0, "}\n"));
+}
+
+/*! Return a human-readable description of a libkdiv status code.
+ */
+const char *kdiv_strerror(int err)
+{
+  switch (err)
+  {
+    case KDIV_OK:
+      return ("Success.");
+    case KDIV_E_DIVZERO:
+      return ("Requested division by zero.");
+    case KDIV_E_WIDTH:
+      return ("Bitwidth must be in the range [2, 32].");
+    case KDIV_E_SIGN:
+      return ("Divisor must be positive for unsigned division.");
+    case KDIV_E_RANGE:
+      return ("Divisor is not representable in the given bitwidth.");
+    case KDIV_E_UNSUPPORTED:
+      return ("Unsupported constant division.");
+    case KDIV_E_NOSPACE:
+      return ("Output buffer too small.");
+    case KDIV_E_ARG:
+      return ("Invalid argument.");
+    case KDIV_E_PROOF:
+      return ("Correctness conditions do not hold.");
+    case KDIV_E_MULWIDTH:
+      return ("Multiplier width must be at least 8 and divide the bitwidth.");
+    default:
+      return ("Unknown error.");
+  }
+}
+
+/*! Check that a divisor can be handled for the given bitwidth and signedness:
+ *  1 <= d <= 2^W-1 for unsigned and -2^(W-1) <= d <= 2^(W-1)-1, d != 0, for
+ *  signed division, with 2 <= W <= 32. For W = 32, d = -2^31 is rejected, 
+ *  since |d| does not fit in an int.
+ */
+int kdiv_check(int d, unsigned W, int is_signed)
+{
+  unsigned long long int maxd;
+  
+  if (d == 0)
+  {
+    return (KDIV_E_DIVZERO);
+  }
+  if ((W < 2) || (W > 32))
+  {
+    return (KDIV_E_WIDTH);
+  }
+  if ((is_signed == 0) && (d < 0))
+  {
+    return (KDIV_E_SIGN);
+  }
+  maxd = (is_signed == 0) ? kdiv_ipowul(2, W) - 1 : kdiv_ipowul(2, W-1) - 1;
+  if ((d < 0 && (d == -2147483647-1 || (unsigned long long int)(-d) > maxd + 1)) ||
+      (d > 0 && (unsigned long long int)d > maxd))
+  {
+    return (KDIV_E_RANGE);
+  }
+  return (KDIV_OK);
+}
+
+/*! Write the name of the routine described by spec, e.g. "kdiv_u32_p_7".
+ */
+int kdiv_routine_name(struct kdiv_buf *b, const struct kdiv_spec *spec)
+{
+  char ch;
+  
+  if ((b == NULL) || (spec == NULL))
+  {
+    return (KDIV_E_ARG);
+  }
+  ch = (spec->is_signed == 0) ? 'u' : 's';
+  kdiv_bprintf(b, 0, "kdiv_%c%u_%c_%d", ch, spec->width, 
+    ((spec->divisor > 0) ? 'p' : 'm'), ABS(spec->divisor));
+  if ((spec->mulwidth != 0) && (spec->mulwidth < spec->width))
+  {
+    kdiv_bprintf(b, 0, "_m%u", spec->mulwidth);
+  }
+  return (kdiv_buf_status(b));
+}
+
+/*! Return the customary file suffix for routines in the given language.
+ */
+const char *kdiv_lang_suffix(int lang)
+{
+  return ((lang == KDIV_LANG_ANSIC) ? "c" : "nac");
+}
+
+/*! Validate spec, calculate its magic numbers and emit the routine into b.
+ */
+int kdiv_generate(struct kdiv_buf *b, const struct kdiv_spec *spec)
+{
+  struct mu magu;
+  struct ms mags;
+  struct kdiv_mulw w;
+  int err;
+  
+  if ((b == NULL) || (spec == NULL) || 
+      ((spec->lang != KDIV_LANG_NAC) && (spec->lang != KDIV_LANG_ANSIC)))
+  {
+    return (KDIV_E_ARG);
+  }
+  err = kdiv_check(spec->divisor, spec->width, spec->is_signed);
+  if (err != KDIV_OK)
+  {
+    return (err);
+  }
+  
+  if ((spec->mulwidth != 0) && (spec->mulwidth < spec->width))
+  {
+    err = (spec->is_signed == 0) 
+        ? kdiv_mulw_u(&w, spec->divisor, spec->width, spec->mulwidth)
+        : kdiv_mulw_s(&w, spec->divisor, spec->width, spec->mulwidth);
+    if (err != KDIV_OK)
+    {
+      return (err);
+    }
+    if (spec->is_signed == 0)
+    {
+      return ((spec->lang == KDIV_LANG_NAC) ? emit_kdivu_mulw_nac(b, &w) 
+                                            : emit_kdivu_mulw_ansic(b, &w));
+    }
+    return ((spec->lang == KDIV_LANG_NAC) ? emit_kdivs_mulw_nac(b, &w) 
+                                          : emit_kdivs_mulw_ansic(b, &w));
+  }
+  if (spec->is_signed == 0)
+  {
+    magu = kdiv_magicu(spec->divisor, spec->width);
+    if (spec->lang == KDIV_LANG_NAC)
+    {
+      err = emit_kdivu_nac(b, magu.M, magu.a, magu.s, spec->divisor, spec->width);
+    }
+    else
+    {
+      err = emit_kdivu_ansic(b, magu.M, magu.a, magu.s, spec->divisor, spec->width);
+    }
+  }
+  else
+  {
+    mags = kdiv_magic(spec->divisor, spec->width);
+    if (spec->lang == KDIV_LANG_NAC)
+    {
+      err = emit_kdivs_nac(b, mags.M, mags.s, spec->divisor, spec->width);
+    }
+    else
+    {
+      err = emit_kdivs_ansic(b, mags.M, mags.s, spec->divisor, spec->width);
+    }
+  }
+  return (err);
+}
@@ -4,12 +4,12 @@
 inline signed int kdiv_s32_p_23 (signed int n)
 {
   signed int q, M=-1307163959, c;
-  signed long long int t, u, v;
+  signed long long int t;
   t = (signed long long int)M * (signed long long int)n;
   q = t >> 32;
   q = q + n;
   q = q >> 4;
-  c = n >> 31;
+  c = (unsigned int)n >> 31;
   q = q + c;
   return (q);
 }
@@ -0,0 +1,72 @@
+// test.scan.c
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef KDIV_SCAN_MAIN
+const unsigned int ro_div = 1000;
+const int ro_sdiv = -7;
+
+unsigned int div_imm (unsigned int n);
+int sdiv_imm (int n);
+unsigned int div_ro (unsigned int n);
+int sdiv_ro (int n);
+unsigned int div_var (unsigned int n, unsigned int d);
+unsigned long long div_u64 (unsigned long long n);
+unsigned int div_idx (const unsigned int *a, unsigned int n, long i);
+unsigned int div_switch (unsigned int n, unsigned int d, int k);
+
+int main(int argc, char *argv[]) {
+  unsigned int a;
+  a = (argc > 1) ? (unsigned int)atoi(argv[1]) : 123456789;
+  printf("%u %d %u %d %u %llu\n", div_imm(a), sdiv_imm((int)a), div_ro(a),
+    sdiv_ro((int)a), div_var(a, 3), div_u64(a));
+  printf("%u %u %u\n", div_idx(&ro_div, a, 0), div_switch(a, 3, 0),
+    div_switch(a, 3, 1));
+  return 0;
+}
+#else
+extern const unsigned int ro_div;
+extern const int ro_sdiv;
+
+unsigned int div_imm (unsigned int n) { return n / 7; }
+int sdiv_imm (int n) { return n / 10; }
+unsigned int div_ro (unsigned int n) { return n / ro_div; }
+int sdiv_ro (int n) { return n / ro_sdiv; }
+unsigned int div_var (unsigned int n, unsigned int d) { return n / d; }
+unsigned long long div_u64 (unsigned long long n) { return n / 641ULL; }
+unsigned int div_idx (const unsigned int *a, unsigned int n, long i) { return n / a[i]; }
+// Case 1 is reached through the jump table with the runtime d.
+unsigned int div_switch (unsigned int n, unsigned int d, int k)
+{
+  switch (k)
+  {
+    case 0: d = 7; /* fall through */
+    case 1: return n / d;
+    case 2: return n + d;
+    case 3: return n - d;
+    case 4: return n * d;
+    case 5: return n ^ d;
+    case 6: return n & (d + 3);
+    default: return 0;
+  }
+}
+#if defined(__x86_64__) && defined(__ELF__)
+// The divisor 7 reaches the div on one path only: it must not be reported.
+__asm__(
+  "  .text\n"
+  "  .globl div_join\n"
+  "  .type div_join, @function\n"
+  "div_join:\n"
+  "  mov %edi, %eax\n"
+  "  mov %esi, %ecx\n"
+  "  xor %edx, %edx\n"
+  "  test %ecx, %ecx\n"
+  "  jne 1f\n"
+  "  mov $7, %ecx\n"
+  "  xor %edx, %edx\n"
+  "1:\n"
+  "  div %ecx\n"
+  "  ret\n"
+  "  .size div_join, .-div_join\n");
+#endif
+#endif
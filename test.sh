@@ -18,6 +18,99 @@ do
   ./kdiv${EXE} -div ${divs} -width 32 -signed -ansic
 done
 
+# The most negative divisor of a narrow width, -2^(W-1)
+./kdiv${EXE} -div -32768 -width 16 -signed -nac -d -errors -lo -32768 -hi 32767
+
+# Split the high multiply for 16-bit and 8-bit target multipliers
+for div in "3" "7" "10" "641" "1000" "12345"
+do
+  ./kdiv${EXE} -div ${div} -width 32 -unsigned -nac -mulwidth 16 -stats -d -errors
+  ./kdiv${EXE} -div ${div} -width 32 -unsigned -ansic -mulwidth 8 -d -errors -selftest -lo 0 -hi 2000000
+  ./kdiv${EXE} -div -${div} -width 32 -signed -ansic -mulwidth 16 -d -errors -selftest -lo -2000000 -hi 2000000
+  ./kdiv${EXE} -div ${div} -width 16 -signed -nac -mulwidth 8 -d -errors -lo -32768 -hi 32767
+done
+
+# Cost metrics of a few routines and of whole divisor ranges
+./kdiv${EXE} -div 7 -width 32 -unsigned -nac -stats
+./kdiv${EXE} -div -7 -width 32 -signed -nac -stats
+./kdiv${EXE} -sweep -width 32 -unsigned -dlo 1 -dhi 65536
+./kdiv${EXE} -sweep -width 32 -signed -dlo -32768 -dhi 32767
+
+# Prove whole divisor spaces (and a slice of the 32-bit one) correct
+./kdiv${EXE} -prove -width 16 -unsigned -errors
+./kdiv${EXE} -prove -width 16 -signed -errors
+./kdiv${EXE} -prove -width 32 -unsigned -dlo 1 -dhi 1000000 -errors
+./kdiv${EXE} -prove -width 32 -signed -dlo -1000000 -dhi 1000000 -errors
+
+# Modular multiplication kernels for a few constant moduli
+for mod in "10" "255" "65521" "998244353" "1000000007" "4294967291"
+do
+  ./kdiv${EXE} -mod ${mod} -nac
+  ./kdiv${EXE} -mod ${mod} -ansic -bench -d -errors -lo 0 -hi 65535
+done
+
+# Division of multi-limb integers by single-limb constants
+for div in "1" "3" "10" "255" "1000000000" "2147483648" "4294967295"
+do
+  ./kdiv${EXE} -bigdiv ${div} -bench -d -errors -lo 0 -hi 65535
+done
+
+# Floating-point reciprocal routines over whole widths and dividend ranges
+for div in "1" "3" "7" "10" "641" "1000" "12345"
+do
+  ./kdiv${EXE} -div ${div} -width 32 -unsigned -fp -stats -bench -d -errors
+  ./kdiv${EXE} -div -${div} -width 32 -signed -fp -stats -d -errors -lo -65535 -hi 65535
+  ./kdiv${EXE} -div ${div} -width 24 -unsigned -fp -d -errors -lo 0 -hi 16777215
+done
+
+# Interleaved batch routines and their benchmark
+for div in "3" "7" "10" "641" "1000"
+do
+  ./kdiv${EXE} -div ${div} -width 32 -unsigned -ansic -batch 4 -bench
+  gcc -O2 -o kdiv_batch_bench${EXE} kdiv_u32_p_${div}_batch_bench.c
+  ./kdiv_batch_bench${EXE}
+  ./kdiv${EXE} -div -${div} -width 32 -signed -ansic -batch 8
+  ./kdiv${EXE} -div ${div} -width 32 -signed -ansic -batch 2
+done
+
+# Profile-guided dispatch routines for runtime divisors
+./kdiv${EXE} -profile test.hist.txt -ansic -unsigned -d -errors
+./kdiv${EXE} -profile test.hist.txt -ansic -signed -hot 16 -divcost 40 -d -errors
+
+# Per-lane routines for a dictionary of divisors
+./kdiv${EXE} -dict test.dict.txt -unsigned -bench -d -lo 0 -hi 1000000
+./kdiv${EXE} -dict test.dict.txt -signed -bench -d -errors -lo -1000000 -hi 1000000
+
+# Build and run the emitted vector routines against hardware division
+for sign in "u" "s"
+do
+  gcc -O2 -mavx2 -o kdiv_dict_bench${EXE} kdiv_${sign}32_dict_bench.c
+  ./kdiv_dict_bench${EXE}
+  if grep -qw avx512f /proc/cpuinfo 2>/dev/null
+  then
+    gcc -O2 -mavx512f -o kdiv_dict_bench${EXE} kdiv_${sign}32_dict_bench.c
+    ./kdiv_dict_bench${EXE}
+  fi
+done
+
+# Native self-test of the emitted routines against hardware division
+for div in "1" "2" "7" "10" "641" "1000"
+do
+  ./kdiv${EXE} -div ${div} -width 32 -unsigned -ansic -selftest -errors -lo 0 -hi 4000000
+  ./kdiv${EXE} -div -${div} -width 32 -signed -ansic -mulwidth 16 -selftest -errors -lo -2000000 -hi 2000000
+  ./kdiv${EXE} -div ${div} -width 32 -signed -ansic -selftest -errors -lo -2000000 -hi 2000000
+done
+./kdiv${EXE} -div -7 -width 32 -signed -ansic -selftest -errors
+./kdiv${EXE} -div 7 -width 32 -unsigned -ansic -mulwidth 16 -selftest -errors
+
+# Measure concurrent routine generation with libkdiv
+./kdivbench${EXE} -threads 4 -count 10000
+
+# Scan an object file and a linked executable for divisions by constants
+gcc -Os -c test.scan.c -o test.scan.o
+gcc -Os -DKDIV_SCAN_MAIN test.scan.c test.scan.o -o test.scan${EXE}
+./kdivscan${EXE} -ansic test.scan.o test.scan${EXE}
+
 if [ "$SECONDS" -eq 1 ]
 then
   units=second